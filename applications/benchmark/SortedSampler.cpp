@@ -0,0 +1,62 @@
+/*
+ * GeneTrail2 - An efficient library for interpreting genetic data
+ * Copyright (C) 2016 Daniel Stöckel <dstoeckel@bioinf.uni-sb.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Lesser GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Lesser GNU General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "SortedSampler.h"
+
+namespace GeneTrail
+{
+	void SortedSampler::collectRemaining_()
+	{
+		for(size_t i = 0; i < used_.size(); ++i) {
+			if(!used_[i]) {
+				remaining_.push_back(i);
+			}
+		}
+	}
+
+	void SortedSampler::merge_(size_t a, size_t k)
+	{
+		sample_.resize(k);
+
+		// Merge the old sample [0, a) and the new elements from the back.
+		// As soon as all new elements are placed, the remaining old
+		// elements already are at the correct position.
+		size_t i = a;
+		size_t j = new_elements_.size();
+		size_t w = k;
+		while(j > 0) {
+			if(i > 0 && sample_[i - 1] > new_elements_[j - 1]) {
+				sample_[--w] = sample_[--i];
+			} else {
+				sample_[--w] = new_elements_[--j];
+			}
+		}
+	}
+
+	void SortedSampler::clear()
+	{
+		for(auto pos : positions_) {
+			used_[pos] = 0;
+		}
+
+		positions_.clear();
+		remaining_.clear();
+		sample_.clear();
+	}
+}
@@ -0,0 +1,138 @@
+/*
+ * GeneTrail2 - An efficient library for interpreting genetic data
+ * Copyright (C) 2016 Daniel Stöckel <dstoeckel@bioinf.uni-sb.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Lesser GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Lesser GNU General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef GT2_BENCHMARK_SORTED_SAMPLER_H
+#define GT2_BENCHMARK_SORTED_SAMPLER_H
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace GeneTrail
+{
+	/**
+	 * Draws a uniformly distributed random subset from a pool of indices
+	 * that can be grown incrementally and that is always kept in sorted
+	 * order.
+	 *
+	 * As long as the sample contains less than half of the pool, new
+	 * elements are drawn by rejection sampling, which needs less than two
+	 * draws per element in expectation. Larger samples are completed by
+	 * a partial Fisher-Yates shuffle of the remaining elements. Growing
+	 * the sample from size a to size b thus costs O((b - a) log(b - a))
+	 * for drawing the new elements and sorting them. The new elements are
+	 * merged into the sample from the back, so only elements that are
+	 * larger than the smallest new element are moved.
+	 *
+	 * This is an alternative to shuffling the pool and sorting the
+	 * prefixes of the shuffled pool, which needs to sort, merge, and copy
+	 * the whole prefix for every sample size.
+	 */
+	class SortedSampler
+	{
+		public:
+		/**
+		 * Creates a sampler for the indices in [begin, end). The indices
+		 * must be distinct.
+		 */
+		template <typename InputIterator>
+		SortedSampler(InputIterator begin, InputIterator end)
+		    : pool_(begin, end), used_(pool_.size(), 0)
+		{
+			std::sort(pool_.begin(), pool_.end());
+		}
+
+		/**
+		 * Removes all elements from the sample. This costs O(k) where k is
+		 * the current size of the sample.
+		 */
+		void clear();
+
+		/**
+		 * Adds random elements to the sample until it contains k elements.
+		 * If the sample already contains k or more elements, nothing
+		 * happens.
+		 *
+		 * @param k   The new size of the sample. Must not exceed the size
+		 *            of the pool.
+		 * @param rng A random number generator returning unsigned integers.
+		 */
+		template <typename RandomNumberGenerator>
+		void grow(size_t k, RandomNumberGenerator& rng)
+		{
+			assert(k <= pool_.size());
+
+			const size_t a = sample_.size();
+			if(k <= a) {
+				return;
+			}
+
+			const size_t n = pool_.size();
+
+			new_elements_.clear();
+			for(size_t i = a; i < k; ++i) {
+				size_t pos;
+				if(2 * i < n) {
+					do {
+						pos = rng() % n;
+					} while(used_[pos]);
+				} else {
+					if(remaining_.empty()) {
+						collectRemaining_();
+					}
+
+					auto j = rng() % remaining_.size();
+					pos = remaining_[j];
+					remaining_[j] = remaining_.back();
+					remaining_.pop_back();
+				}
+
+				used_[pos] = 1;
+				positions_.push_back(pos);
+				new_elements_.push_back(pool_[pos]);
+			}
+
+			std::sort(new_elements_.begin(), new_elements_.end());
+			merge_(a, k);
+		}
+
+		/// The number of elements in the sample.
+		size_t size() const { return sample_.size(); }
+
+		/// The sorted sample.
+		const std::vector<size_t>& sample() const { return sample_; }
+
+		private:
+		void collectRemaining_();
+		void merge_(size_t a, size_t k);
+
+		// The sorted pool of indices from which the samples are drawn.
+		std::vector<size_t> pool_;
+		// Marks the positions of the pool that are part of the sample.
+		std::vector<char> used_;
+		// The unused positions, only filled once the sample is large.
+		std::vector<size_t> remaining_;
+
+		std::vector<size_t> sample_;
+		std::vector<size_t> positions_;
+		std::vector<size_t> new_elements_;
+	};
+}
+
+#endif // GT2_BENCHMARK_SORTED_SAMPLER_H
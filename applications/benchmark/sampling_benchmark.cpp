@@ -0,0 +1,233 @@
+/*
+ * GeneTrail2 - An efficient library for interpreting genetic data
+ * Copyright (C) 2016 Daniel Stöckel <dstoeckel@bioinf.uni-sb.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Compares the shuffle engine of the RowPermutationTest with the
+ * SortedSampler for drawing sorted random samples of all category sizes.
+ * The RowPermutationTest only uses the former, as the SortedSampler did
+ * not outperform it in this benchmark. The category sizes are drawn from
+ * log-normal distributions that roughly resemble the size distributions
+ * of KEGG, Reactome, and GO.
+ */
+
+#include "SortedSampler.h"
+
+#include <boost/iterator/counting_iterator.hpp>
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace GeneTrail;
+namespace bpo = boost::program_options;
+
+struct Params
+{
+	size_t genes;
+	size_t permutations;
+	size_t minimum;
+	size_t maximum;
+	uint64_t seed;
+};
+
+struct SizeDistribution
+{
+	std::string name;
+	size_t categories;
+	double median;
+	double sigma;
+};
+
+bool parseArguments(int argc, char* argv[], Params& p)
+{
+	bpo::variables_map vm;
+	bpo::options_description desc;
+
+	desc.add_options()("help,h", "Display this message")(
+	    "genes,g", bpo::value(&p.genes)->default_value(20000),
+	    "Number of genes from which the samples are drawn.")(
+	    "permutations,p", bpo::value(&p.permutations)->default_value(1000),
+	    "Number of permutations per engine and distribution.")(
+	    "minimum,n", bpo::value(&p.minimum)->default_value(2),
+	    "Minimum category size.")(
+	    "maximum,x", bpo::value(&p.maximum)->default_value(1000),
+	    "Maximum category size.")(
+	    "seed,e", bpo::value(&p.seed)->default_value(42),
+	    "Seed for the random number generator.");
+
+	try
+	{
+		bpo::store(bpo::command_line_parser(argc, argv).options(desc).run(),
+		           vm);
+
+		if(vm.count("help")) {
+			desc.print(std::cerr);
+			return false;
+		}
+
+		bpo::notify(vm);
+	}
+	catch(bpo::error& e)
+	{
+		std::cerr << "ERROR: " << e.what() << "\n";
+		desc.print(std::cerr);
+		return false;
+	}
+
+	if(p.minimum == 0 || p.minimum > p.maximum || p.maximum > p.genes) {
+		std::cerr << "ERROR: The category sizes must satisfy 0 < minimum <= "
+		             "maximum <= genes.\n";
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Draws the sizes of the categories and returns the sorted, distinct sizes.
+ * Only distinct sizes are relevant for the engines.
+ */
+std::vector<size_t> drawSizes(const SizeDistribution& dist, const Params& p,
+                              std::mt19937_64& rng)
+{
+	std::lognormal_distribution<double> lognormal(std::log(dist.median),
+	                                              dist.sigma);
+
+	std::vector<size_t> sizes(dist.categories);
+	for(auto& s : sizes) {
+		auto size = static_cast<size_t>(std::round(lognormal(rng)));
+		s = std::min(p.maximum, std::max(p.minimum, size));
+	}
+
+	std::sort(sizes.begin(), sizes.end());
+	sizes.erase(std::unique(sizes.begin(), sizes.end()), sizes.end());
+
+	return sizes;
+}
+
+/**
+ * The engine used by RowPermutationTest::presort_: shuffle a prefix and
+ * sort it incrementally using sort, merge, and copy.
+ */
+size_t runShuffle(const std::vector<size_t>& sizes, const Params& p,
+                  std::mt19937_64& rng)
+{
+	std::vector<size_t> indices(p.genes);
+	std::vector<size_t> tmp(p.genes);
+	std::iota(indices.begin(), indices.end(), 0);
+
+	const size_t n = indices.size();
+	size_t checksum = 0;
+
+	for(size_t k = 0; k < p.permutations; ++k) {
+		for(size_t i = 0; i < sizes.back(); ++i) {
+			std::swap(indices[i], indices[i + rng() % (n - i)]);
+		}
+
+		size_t a = 0;
+		for(auto b : sizes) {
+			std::sort(indices.begin() + a, indices.begin() + b);
+			std::merge(indices.begin(), indices.begin() + a,
+			           indices.begin() + a, indices.begin() + b, tmp.begin());
+			std::copy(tmp.begin(), tmp.begin() + b, indices.begin());
+			a = b;
+
+			checksum += indices[b / 2];
+		}
+	}
+
+	return checksum;
+}
+
+size_t runSortedSampler(const std::vector<size_t>& sizes, const Params& p,
+                        std::mt19937_64& rng)
+{
+	SortedSampler sampler(boost::counting_iterator<size_t>(0),
+	                      boost::counting_iterator<size_t>(p.genes));
+
+	size_t checksum = 0;
+
+	for(size_t k = 0; k < p.permutations; ++k) {
+		sampler.clear();
+
+		for(auto b : sizes) {
+			sampler.grow(b, rng);
+			checksum += sampler.sample()[b / 2];
+		}
+	}
+
+	return checksum;
+}
+
+template <typename Engine>
+void benchmark(const std::string& name, const std::vector<size_t>& sizes,
+               const Params& p, Engine engine)
+{
+	std::mt19937_64 rng(p.seed);
+
+	auto start = std::chrono::steady_clock::now();
+	auto checksum = engine(sizes, p, rng);
+	auto stop = std::chrono::steady_clock::now();
+
+	std::chrono::duration<double, std::micro> elapsed = stop - start;
+
+	std::cout << "  " << std::left << std::setw(16) << name << std::right
+	          << std::setw(12) << std::fixed << std::setprecision(2)
+	          << elapsed.count() / p.permutations << " us/permutation"
+	          << "  (checksum " << checksum << ")\n";
+}
+
+int main(int argc, char* argv[])
+{
+	Params p;
+	if(!parseArguments(argc, argv, p)) {
+		return -1;
+	}
+
+	// Rough approximations of the category size distributions of the
+	// respective databases.
+	std::vector<SizeDistribution> distributions{
+	    {"KEGG", 300, 70.0, 0.9},
+	    {"Reactome", 2000, 25.0, 1.2},
+	    {"GO", 12000, 12.0, 1.3}};
+
+	std::mt19937_64 rng(p.seed);
+
+	for(const auto& dist : distributions) {
+		auto sizes = drawSizes(dist, p, rng);
+
+		std::cout << dist.name << ": " << sizes.size()
+		          << " distinct category sizes, largest " << sizes.back()
+		          << "\n";
+
+		benchmark("shuffle", sizes, p, runShuffle);
+		benchmark("sorted-sampler", sizes, p, runSortedSampler);
+	}
+
+	return 0;
+}
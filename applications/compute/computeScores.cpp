@@ -18,6 +18,7 @@ namespace bpo = boost::program_options;
 
 std::string expr1 = "", expr2 = "", output = "", method = "", groups = "";
 bool binary = false;
+size_t numThreads = 1;
 
 MatrixReaderOptions matrixOptions;
 
@@ -34,7 +35,8 @@ bool parseArguments(int argc, char* argv[])
 		("no-row-names,r", bpo::value<bool>(&matrixOptions.no_rownames)->default_value(false)->zero_tokens(), "Does the file contain row names.")
 		("no-col-names,c", bpo::value<bool>(&matrixOptions.no_colnames)->default_value(false)->zero_tokens(), "Does the file contain column names.")
 		("add-col-name,a", bpo::value<bool>(&matrixOptions.additional_colname)->default_value(false)->zero_tokens(), "File containing two lines specifying which rownames belong to which group.")
-		("method,m", bpo::value<std::string>(&method)->required(), "Method used for scoring.");
+		("method,m", bpo::value<std::string>(&method)->required(), "Method used for scoring.")
+		("threads,j", bpo::value<size_t>(&numThreads)->default_value(1), "Number of threads used by methods that score all rows at once.");
 
 	try
 	{
@@ -88,6 +90,7 @@ int main(int argc, char* argv[])
 		auto subset = splitMatrix(matrix, reference, sample);
 
 		MatrixHTest htest;
+		htest.setNumberOfThreads(numThreads);
 		auto gene_set = htest.test(method, std::get<0>(subset), std::get<1>(subset));
 
 		for(const auto& score : gene_set.scores()) {
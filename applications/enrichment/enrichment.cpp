@@ -75,6 +75,7 @@ int main(int argc, char* argv[])
 	Scores scores(test_set, db);
 
 	auto algorithm = getAlgorithm(p.pValueMode, method, scores);
+	p.statistic = method;
 
 	run(scores, cat_list, algorithm, p, true);
 }
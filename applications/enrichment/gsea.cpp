@@ -6,10 +6,13 @@
 #include <genetrail2/enrichment/Parameters.h>
 
 #include <genetrail2/core/EntityDatabase.h>
+#include <genetrail2/core/Exception.h>
+#include <genetrail2/core/KolmogorovSmirnovPValueCache.h>
 
 #include <boost/program_options.hpp>
 
 #include <algorithm>
+#include <fstream>
 #include <iostream>
 #include <memory>
 
@@ -17,6 +20,7 @@ using namespace GeneTrail;
 namespace bpo = boost::program_options;
 
 bool increasing = false, absolute = false;
+std::string pvalue_cache;
 
 bool parseArguments(int argc, char* argv[], Params& p)
 {
@@ -27,7 +31,8 @@ bool parseArguments(int argc, char* argv[], Params& p)
 	desc.add_options()
 		("identifier, d", bpo::value(&p.identifier_), "A file containing identifier line by line.")
 		("increasing,i",  bpo::value(&increasing)->zero_tokens(), "Use increasingly sorted scores. (Decreasing is default)")
-		("absolute,b",  bpo::value(&absolute)->zero_tokens(), "Use decreasingly sorted absolute scores.");
+		("absolute,b",  bpo::value(&absolute)->zero_tokens(), "Use decreasingly sorted absolute scores.")
+		("pvalue_cache", bpo::value(&pvalue_cache), "A file in which the exact row-wise p-values are cached across runs. It is created if it does not exist.");
 
 	if(absolute && increasing) {
 		std::cerr << "ERROR: Please specify only one option to sort the file."
@@ -79,10 +84,31 @@ int main(int argc, char* argv[])
 		prepareScores(scores);
 	}
 
+	auto cache = std::make_shared<KolmogorovSmirnovPValueCache>();
+	if(pvalue_cache != "" && std::ifstream(pvalue_cache)) {
+		try {
+			cache->read(pvalue_cache);
+		} catch(IOError& exn) {
+			std::cerr << "WARNING: Could not read p-value cache. Reason: "
+			          << exn.what() << std::endl;
+		}
+	}
+
 	// TODO: Improve this interface.
 	auto gsea = createEnrichmentAlgorithm<KolmogorovSmirnov>(
-	    p.pValueMode, scores.indices().begin(), scores.indices().end(), increasing ? Order::Increasing : Order::Decreasing);
+	    p.pValueMode, scores.indices().begin(), scores.indices().end(), increasing ? Order::Increasing : Order::Decreasing, cache);
+	p.statistic = "gsea";
 
 	run(scores, cat_list, gsea, p, true);
+
+	if(pvalue_cache != "") {
+		try {
+			cache->write(pvalue_cache);
+		} catch(IOError& exn) {
+			std::cerr << "WARNING: Could not write p-value cache. Reason: "
+			          << exn.what() << std::endl;
+		}
+	}
+
 	return 0;
 }
@@ -65,7 +65,7 @@ double computeEnrichment(const DenseMatrix& cdata, const DenseMatrix& sdata,
 	indices.reserve(c.size());
 
 	for(const auto& s : c.names()) {
-		auto i = cdata.colIndex(s);
+		auto i = cdata.colIndex(s.to_string());
 
 		if(i != std::numeric_limits<decltype(i)>::max()) {
 			indices.push_back(i);
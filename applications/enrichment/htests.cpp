@@ -74,6 +74,7 @@ int main(int argc, char* argv[])
 	Scores scores(test_set, db);
 
 	auto algorithm = getAlgorithm(method, scores, p.pValueMode);
+	p.statistic = method;
 
 	run(scores, cat_list, algorithm, p, true);
 }
@@ -2,6 +2,7 @@
 #include <genetrail2/core/Exception.h>
 #include <genetrail2/core/GeneSet.h>
 #include <genetrail2/core/GeneSetReader.h>
+#include <genetrail2/core/LogFactorialTable.h>
 #include <genetrail2/core/OverRepresentationAnalysis.h>
 
 #include <genetrail2/enrichment/common.h>
@@ -15,6 +16,7 @@ using namespace GeneTrail;
 namespace bpo = boost::program_options;
 
 std::string reference;
+DirectoryPath logFactorialCache;
 
 bool parseArguments(int argc, char* argv[], Params& p)
 {
@@ -24,7 +26,8 @@ bool parseArguments(int argc, char* argv[], Params& p)
 	addCommonCLIArgs(desc, p);
 	desc.add_options()
 		("identifier, d", bpo::value(&p.identifier_), "A file containing identifier line by line.")
-		("reference, r", bpo::value<std::string>(&reference)->required(), "A file containing identifier line by line.");
+		("reference, r", bpo::value<std::string>(&reference)->required(), "A file containing identifier line by line.")
+		("log_factorial_cache", bpo::value(&logFactorialCache), "A directory in which the tables of log-factorials used for computing p-values are cached, so that subsequent runs do not need to recompute them.");
 
 	try
 	{
@@ -48,6 +51,8 @@ int main(int argc, char* argv[])
 		return -1;
 	}
 
+	LogFactorialTable::setCacheDirectory(logFactorialCache.directoryPath);
+
 	GeneSet test_set;
 	GeneSet reference_set;
 	CategoryList cat_list;
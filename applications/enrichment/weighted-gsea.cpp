@@ -65,6 +65,7 @@ int main(int argc, char* argv[])
 	auto order = increasing ? Order::Increasing : Order::Decreasing;
 
 	auto algorithm = createEnrichmentAlgorithm<WeightedKolmogorovSmirnov>(p.pValueMode, scores, order);
+	p.statistic = "weighted-gsea";
 
 	run(scores, cat_list, algorithm, p, true);
 	return 0;
@@ -0,0 +1,141 @@
+/*
+ * GeneTrail2 - An efficient library for interpreting genetic data
+ * Copyright (C) 2016 Daniel Stöckel <dstoeckel@bioinf.uni-sb.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Lesser GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Lesser GNU General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "BatchOverRepresentationAnalysis.h"
+
+#include "Category.h"
+#include "CategoryDatabase.h"
+#include "LogFactorialTable.h"
+#include "OverRepresentationAnalysis.h"
+
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+
+namespace GeneTrail
+{
+	BatchOverRepresentationAnalysis::BatchOverRepresentationAnalysis(
+	    const CategoryDatabase& db, const Category& reference_set)
+	    : reference_hits_(db.size()),
+	      reference_bits_(reference_set),
+	      m_(reference_set.size())
+	{
+		size_t num_entities = 0;
+		for(const auto& c : db) {
+			if(c.size() != 0) {
+				num_entities = std::max<size_t>(num_entities, *std::prev(c.end()) + 1);
+			}
+		}
+
+		// Count the postings of every entity and turn the counts into
+		// offsets. The categories are visited in order, so every postings
+		// list is sorted.
+		offsets_.assign(num_entities + 1, 0);
+		for(const auto& c : db) {
+			for(auto i : c) {
+				++offsets_[i + 1];
+			}
+		}
+
+		std::partial_sum(offsets_.begin(), offsets_.end(), offsets_.begin());
+
+		std::vector<size_t> fill(offsets_.begin(), offsets_.end() - 1);
+		postings_.resize(offsets_.back());
+		for(size_t j = 0; j < db.size(); ++j) {
+			for(auto i : db[j]) {
+				postings_[fill[i]++] = static_cast<uint32_t>(j);
+			}
+
+			reference_hits_[j] = reference_bits_.intersectionSize(db[j]);
+		}
+	}
+
+	std::vector<size_t>
+	BatchOverRepresentationAnalysis::countHits_(const Category& test_set) const
+	{
+		std::vector<size_t> k(numCategories(), 0);
+		for(auto i : test_set) {
+			if(i + 1 < offsets_.size()) {
+				for(size_t p = offsets_[i]; p < offsets_[i + 1]; ++p) {
+					++k[postings_[p]];
+				}
+			}
+		}
+
+		return k;
+	}
+
+	std::vector<std::pair<size_t, size_t>>
+	BatchOverRepresentationAnalysis::hits(const Category& test_set) const
+	{
+		const auto k = countHits_(test_set);
+
+		std::vector<std::pair<size_t, size_t>> result;
+		for(size_t j = 0; j < k.size(); ++j) {
+			if(k[j] != 0) {
+				result.emplace_back(j, k[j]);
+			}
+		}
+
+		return result;
+	}
+
+	std::vector<BatchOverRepresentationAnalysis::Result>
+	BatchOverRepresentationAnalysis::compute(const Category& test_set) const
+	{
+		const size_t n = test_set.size();
+		const auto table = LogFactorialTable::get(m_ + n);
+
+		bool useHypergeometricTest = true;
+		for(auto i : test_set) {
+			if(!reference_bits_.test(i)) {
+				useHypergeometricTest = false;
+				break;
+			}
+		}
+
+		const auto k = countHits_(test_set);
+
+		std::vector<Result> results(numCategories());
+		for(size_t j = 0; j < results.size(); ++j) {
+			const auto l = reference_hits_[j];
+
+			results[j].hits = k[j];
+			results[j].expected_hits = (l * n) / static_cast<double>(m_);
+			results[j].pvalue = OverRepresentationAnalysis::computePValue(
+			    table, m_, l, n, k[j], useHypergeometricTest);
+		}
+
+		return results;
+	}
+
+	std::vector<std::vector<BatchOverRepresentationAnalysis::Result>>
+	BatchOverRepresentationAnalysis::compute(
+	    const std::vector<Category>& test_sets) const
+	{
+		std::vector<std::vector<Result>> results;
+		results.reserve(test_sets.size());
+
+		for(const auto& test_set : test_sets) {
+			results.emplace_back(compute(test_set));
+		}
+
+		return results;
+	}
+}
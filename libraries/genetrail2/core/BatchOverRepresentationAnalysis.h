@@ -0,0 +1,109 @@
+/*
+ * GeneTrail2 - An efficient library for interpreting genetic data
+ * Copyright (C) 2016 Daniel Stöckel <dstoeckel@bioinf.uni-sb.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Lesser GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Lesser GNU General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef GT2_CORE_BATCH_OVER_REPRESENTATION_ANALYSIS_H
+#define GT2_CORE_BATCH_OVER_REPRESENTATION_ANALYSIS_H
+
+#include "macros.h"
+
+#include "EntityBitset.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace GeneTrail
+{
+	class Category;
+	class CategoryDatabase;
+	class LogFactorialTable;
+
+	/**
+	 * Over-representation analysis of many test sets against the same
+	 * categories and the same reference set.
+	 *
+	 * The categories are indexed once by an inverted index that maps every
+	 * entity to the categories containing it. The hits of a test set are
+	 * then counted by walking the postings lists of its members only, so
+	 * the cost of counting is proportional to the number of postings of
+	 * the test set instead of the total size of all categories.
+	 */
+	class GT2_EXPORT BatchOverRepresentationAnalysis
+	{
+		public:
+		struct Result
+		{
+			/// Number of genes of the category in the test set
+			size_t hits;
+			/// Expected number of hits under the null hypothesis
+			double expected_hits;
+			/// One-sided p-value, computed as by OverRepresentationAnalysis
+			double pvalue;
+		};
+
+		/**
+		 * Indexes the categories of db. The database must not be modified
+		 * during the lifetime of this object.
+		 */
+		BatchOverRepresentationAnalysis(const CategoryDatabase& db,
+		                                const Category& reference_set);
+
+		/// The number of indexed categories.
+		size_t numCategories() const { return reference_hits_.size(); }
+
+		/**
+		 * Counts the hits of all categories with at least one hit.
+		 *
+		 * @return Pairs of the category index in the database and the
+		 *         number of hits, sorted by the category index.
+		 */
+		std::vector<std::pair<size_t, size_t>>
+		hits(const Category& test_set) const;
+
+		/**
+		 * Computes the results of all categories for the given test set.
+		 * The results are ordered as the categories of the database.
+		 */
+		std::vector<Result> compute(const Category& test_set) const;
+
+		/**
+		 * Computes the results for a batch of test sets.
+		 */
+		std::vector<std::vector<Result>>
+		compute(const std::vector<Category>& test_sets) const;
+
+		private:
+		/// Counts the hits of every category by walking the postings
+		/// lists of the members of test_set.
+		std::vector<size_t> countHits_(const Category& test_set) const;
+
+		// Inverted index in compressed sparse row format: the categories
+		// containing entity i are postings_[offsets_[i], offsets_[i + 1]).
+		std::vector<size_t> offsets_;
+		std::vector<uint32_t> postings_;
+
+		// Number of genes of every category in the reference set
+		std::vector<size_t> reference_hits_;
+
+		EntityBitset reference_bits_;
+		size_t m_;
+	};
+}
+
+#endif // GT2_CORE_BATCH_OVER_REPRESENTATION_ANALYSIS_H
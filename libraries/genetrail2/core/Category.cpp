@@ -21,6 +21,7 @@
 
 #include <algorithm>
 #include <exception>
+#include <iostream>
 
 namespace GeneTrail
 {
@@ -52,7 +53,7 @@ namespace GeneTrail
 		return contains(database_->index(id));
 	}
 
-	bool Category::contains(size_t i) const
+	bool Category::contains(EntityDatabase::index_type i) const
 	{
 		return container_.find(i) != container_.end();
 	}
@@ -62,7 +63,7 @@ namespace GeneTrail
 		return insert(database_->index(id));
 	}
 
-	bool Category::insert(size_t i) { return container_.emplace(i).second; }
+	bool Category::insert(EntityDatabase::index_type i) { return container_.emplace(i).second; }
 
 	size_t Category::size() const { return container_.size(); }
 
@@ -138,7 +139,7 @@ namespace GeneTrail
 		strm << cat.name() << '\t' << cat.reference();
 
 		std::copy(cat.names().begin(), cat.names().end(),
-		          std::ostream_iterator<std::string>(strm, "\t"));
+		          std::ostream_iterator<EntityDatabase::NameRef>(strm, "\t"));
 
 		return strm;
 	}
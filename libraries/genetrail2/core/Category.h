@@ -38,7 +38,7 @@ namespace GeneTrail
 	class GT2_EXPORT Category
 	{
 		private:
-		typedef boost::container::flat_set<size_t> Container;
+		typedef boost::container::flat_set<EntityDatabase::index_type> Container;
 
 		public:
 		typedef Container::iterator iterator;
@@ -131,9 +131,9 @@ namespace GeneTrail
 		// Element access
 		//
 		bool contains(const std::string& id) const;
-		bool contains(size_t i) const;
+		bool contains(EntityDatabase::index_type i) const;
 		bool insert(const std::string& id);
-		bool insert(size_t i);
+		bool insert(EntityDatabase::index_type i);
 
 		const std::shared_ptr<Category>& getParent();
 
@@ -0,0 +1,278 @@
+/*
+ * GeneTrail2 - An efficient library for interpreting genetic data
+ * Copyright (C) 2016 Daniel Stöckel <dstoeckel@bioinf.uni-sb.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Lesser GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Lesser GNU General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "ConcurrentEntityDatabase.h"
+
+#include "Exception.h"
+
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+namespace GeneTrail
+{
+	namespace
+	{
+		/// The initial number of slots of every hash table. A table is
+		/// replaced by one of twice the size once it is half full.
+		const size_t INITIAL_SLOTS = 16;
+
+		// 64 bit FNV-1a hash
+		size_t hashName(boost::string_ref name)
+		{
+			uint64_t hash = 14695981039346656037ull;
+			for(char c : name) {
+				hash ^= static_cast<unsigned char>(c);
+				hash *= 1099511628211ull;
+			}
+			return static_cast<size_t>(hash);
+		}
+	}
+
+	struct ConcurrentEntityDatabase::Node
+	{
+		Node(NameRef n, size_t h) : name(n.to_string()), hash(h), id(0) {}
+
+		std::string name;
+		size_t hash;
+		index_type id;
+	};
+
+	struct ConcurrentEntityDatabase::Table
+	{
+		explicit Table(size_t size)
+		    : mask(size - 1), slots(new std::atomic<const Node*>[size]())
+		{
+		}
+
+		size_t size() const { return mask + 1; }
+
+		/// Stores node in the first free slot of its probe sequence.
+		void insert(const Node* node)
+		{
+			size_t slot = (node->hash / NUM_SHARDS) & mask;
+			while(slots[slot].load(std::memory_order_relaxed) != nullptr) {
+				slot = (slot + 1) & mask;
+			}
+			slots[slot].store(node, std::memory_order_release);
+		}
+
+		size_t mask;
+		std::unique_ptr<std::atomic<const Node*>[]> slots;
+	};
+
+	struct ConcurrentEntityDatabase::Shard
+	{
+		Shard() : table(nullptr) {}
+
+		/// Serialises all insertions into this shard.
+		std::mutex mutex;
+		/// The current table. Readers load it without locking.
+		std::atomic<const Table*> table;
+		/// All tables ever used by the shard. Replaced tables are kept,
+		/// as readers may still be probing them.
+		std::vector<std::unique_ptr<Table>> tables;
+		std::vector<std::unique_ptr<Node>> nodes;
+	};
+
+	ConcurrentEntityDatabase::ConcurrentEntityDatabase()
+	    : shards_(new Shard[NUM_SHARDS]),
+	      chunks_(new std::atomic<const Node**>[NUM_CHUNKS]()),
+	      next_id_(0),
+	      published_(0),
+	      frozen_(false)
+	{
+	}
+
+	ConcurrentEntityDatabase::~ConcurrentEntityDatabase()
+	{
+		for(size_t i = 0; i < NUM_CHUNKS; ++i) {
+			delete[] chunks_[i].load(std::memory_order_relaxed);
+		}
+	}
+
+	void ConcurrentEntityDatabase::locate_(size_t id, size_t& chunk,
+	                                       size_t& offset)
+	{
+		// Chunk c covers the positions [2^c, 2^(c + 1)) * FIRST_CHUNK_SIZE
+		// of the ids shifted by FIRST_CHUNK_SIZE.
+		const uint64_t pos = static_cast<uint64_t>(id) + FIRST_CHUNK_SIZE;
+		const size_t bit = 63 - __builtin_clzll(pos);
+		chunk = bit - FIRST_CHUNK_BITS;
+		offset = pos - (uint64_t(1) << bit);
+	}
+
+	ConcurrentEntityDatabase::NameRef
+	ConcurrentEntityDatabase::name(index_type i) const
+	{
+		size_t chunk, offset;
+		locate_(i, chunk, offset);
+		return chunks_[chunk].load(std::memory_order_acquire)[offset]->name;
+	}
+
+	const ConcurrentEntityDatabase::Node*
+	ConcurrentEntityDatabase::find_(const Shard& shard, NameRef name,
+	                                size_t hash) const
+	{
+		const Table* table = shard.table.load(std::memory_order_acquire);
+
+		if(table == nullptr) {
+			return nullptr;
+		}
+
+		for(size_t slot = (hash / NUM_SHARDS) & table->mask;;
+		    slot = (slot + 1) & table->mask) {
+			const Node* node =
+			    table->slots[slot].load(std::memory_order_acquire);
+
+			if(node == nullptr) {
+				return nullptr;
+			}
+
+			if(node->hash == hash && node->name == name) {
+				return node;
+			}
+		}
+	}
+
+	const ConcurrentEntityDatabase::Node**
+	ConcurrentEntityDatabase::chunk_(size_t chunk)
+	{
+		const Node** nodes = chunks_[chunk].load(std::memory_order_acquire);
+
+		if(nodes == nullptr) {
+			// Threads inserting into different shards may need the same
+			// chunk at the same time. Only one of them installs it.
+			const Node** fresh = new const Node*[FIRST_CHUNK_SIZE << chunk]();
+			if(chunks_[chunk].compare_exchange_strong(
+			       nodes, fresh, std::memory_order_acq_rel)) {
+				nodes = fresh;
+			} else {
+				delete[] fresh;
+			}
+		}
+
+		return nodes;
+	}
+
+	void ConcurrentEntityDatabase::publish_(Node* node)
+	{
+		// The id is only claimed once its chunk exists, so nothing can
+		// fail between claiming and publishing it.
+		size_t id = next_id_.load(std::memory_order_relaxed);
+		size_t chunk, offset;
+		const Node** nodes;
+		do {
+			if(id >= std::numeric_limits<index_type>::max()) {
+				throw std::length_error(
+				    "The ConcurrentEntityDatabase cannot store more entities.");
+			}
+
+			locate_(id, chunk, offset);
+			nodes = chunk_(chunk);
+		} while(!next_id_.compare_exchange_weak(id, id + 1,
+		                                        std::memory_order_acq_rel,
+		                                        std::memory_order_relaxed));
+
+		node->id = static_cast<index_type>(id);
+		nodes[offset] = node;
+
+		// Publish the ids in order, so that size() never covers an id
+		// whose node has not been stored yet. The preceding ids have
+		// already been claimed and are stored without taking any lock.
+		while(published_.load(std::memory_order_acquire) != id) {
+			std::this_thread::yield();
+		}
+		published_.store(id + 1, std::memory_order_release);
+	}
+
+	ConcurrentEntityDatabase::index_type
+	ConcurrentEntityDatabase::index(NameRef name)
+	{
+		const size_t hash = hashName(name);
+		Shard& shard = shards_[hash % NUM_SHARDS];
+
+		if(const Node* node = find_(shard, name, hash)) {
+			return node->id;
+		}
+
+		if(isFrozen()) {
+			throw UnknownEntry(name.to_string());
+		}
+
+		std::lock_guard<std::mutex> lock(shard.mutex);
+
+		// Another thread may have inserted the name in the meantime.
+		if(const Node* node = find_(shard, name, hash)) {
+			return node->id;
+		}
+
+		const Table* table = shard.table.load(std::memory_order_relaxed);
+		if(table == nullptr || 2 * (shard.nodes.size() + 1) > table->size()) {
+			std::unique_ptr<Table> grown(new Table(
+			    table == nullptr ? INITIAL_SLOTS : 2 * table->size()));
+			for(const auto& node : shard.nodes) {
+				grown->insert(node.get());
+			}
+			shard.table.store(grown.get(), std::memory_order_release);
+			shard.tables.push_back(std::move(grown));
+		}
+
+		shard.nodes.push_back(std::unique_ptr<Node>(new Node(name, hash)));
+		Node* node = shard.nodes.back().get();
+
+		try {
+			publish_(node);
+		} catch(...) {
+			shard.nodes.pop_back();
+			throw;
+		}
+
+		// The node is published via the id chunks first, so every thread
+		// that finds it in the table can also look up its name.
+		shard.tables.back()->insert(node);
+
+		return node->id;
+	}
+
+	ConcurrentEntityDatabase::index_type
+	ConcurrentEntityDatabase::index(NameRef name) const
+	{
+		const size_t hash = hashName(name);
+
+		if(const Node* node = find_(shards_[hash % NUM_SHARDS], name, hash)) {
+			return node->id;
+		}
+
+		throw UnknownEntry(name.to_string());
+	}
+
+	EntityDatabase ConcurrentEntityDatabase::toEntityDatabase() const
+	{
+		EntityDatabase result;
+
+		// Ids are assigned in order of insertion, so inserting the names
+		// in the order of their ids reproduces them.
+		for(size_t i = 0; i < size(); ++i) {
+			result.index(name(static_cast<index_type>(i)));
+		}
+
+		return result;
+	}
+}
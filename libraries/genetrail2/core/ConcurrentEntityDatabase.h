@@ -0,0 +1,171 @@
+/*
+ * GeneTrail2 - An efficient library for interpreting genetic data
+ * Copyright (C) 2016 Daniel Stöckel <dstoeckel@bioinf.uni-sb.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Lesser GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Lesser GNU General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef GT2_CORE_CONCURRENT_ENTITY_DATABASE_H
+#define GT2_CORE_CONCURRENT_ENTITY_DATABASE_H
+
+#include "EntityDatabase.h"
+#include "macros.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace GeneTrail
+{
+	/**
+	 * A thread-safe variant of the EntityDatabase that can be shared by
+	 * multiple threads parsing GMT files, score files or matrices.
+	 *
+	 * The names are distributed over a number of shards by their hash.
+	 * Looking up a known name never locks: every shard publishes its hash
+	 * table via an atomic pointer and tables are only ever replaced, never
+	 * modified in place except for filling empty slots. Inserting a new
+	 * name locks the affected shard only, so threads inserting different
+	 * names rarely wait for each other.
+	 *
+	 * Ids are dense and never change once handed out. Their order depends
+	 * on the interleaving of the inserting threads, though.
+	 *
+	 * After loading, freeze() turns the database read-only. From then on
+	 * index() throws for unknown names instead of inserting them and no
+	 * operation takes a lock.
+	 */
+	class GT2_EXPORT ConcurrentEntityDatabase
+	{
+		public:
+		using index_type = EntityDatabase::index_type;
+		using NameRef = EntityDatabase::NameRef;
+
+		ConcurrentEntityDatabase();
+		~ConcurrentEntityDatabase();
+
+		ConcurrentEntityDatabase(const ConcurrentEntityDatabase&) = delete;
+		ConcurrentEntityDatabase&
+		operator=(const ConcurrentEntityDatabase&) = delete;
+
+		/**
+		 * The number of published ids. The names of all ids below size()
+		 * can be accessed via name(), even while other threads insert.
+		 */
+		size_t size() const { return published_.load(std::memory_order_acquire); }
+
+		/**
+		 * Return the name of instance i. The view stays valid for the
+		 * lifetime of the database.
+		 *
+		 * @param i An id returned by index().
+		 * @return The name of the instance.
+		 */
+		NameRef name(index_type i) const;
+
+		/**
+		 * Return the id of an entity. If the entity is not yet known
+		 * and the database is not frozen, a new id will be generated and
+		 * returned.
+		 *
+		 * @param name The name of an entity.
+		 * @return The (possibly new) id of the entity.
+		 *
+		 * @throw UnknownEntry if the database is frozen and the entity
+		 *                     is not registered with the database.
+		 * @throw std::length_error if the id space is exhausted.
+		 */
+		index_type index(NameRef name);
+
+		/**
+		 * Return the id of an entity. This is the constant version,
+		 * which throws an exception if the entity is not known.
+		 *
+		 * @throw UnknownEntry if the entity is not registered with the
+		 *                     database.
+		 */
+		index_type index(NameRef name) const;
+
+		/**
+		 * Overload for index(NameRef)
+		 */
+		index_type operator()(NameRef name) { return index(name); }
+
+		/**
+		 * Overload for index(NameRef) const
+		 */
+		index_type operator()(NameRef name) const { return index(name); }
+
+		/**
+		 * Overload for name(index_type i) const
+		 */
+		NameRef operator()(index_type i) const { return name(i); }
+
+		/**
+		 * Switches the database to the read-only mode. Calling freeze()
+		 * while other threads still insert names is allowed; all
+		 * insertions that completed before remain valid.
+		 */
+		void freeze() { frozen_.store(true, std::memory_order_release); }
+
+		/// Whether freeze() has been called.
+		bool isFrozen() const { return frozen_.load(std::memory_order_acquire); }
+
+		/**
+		 * Copies all entities into an EntityDatabase, which can then be
+		 * used with Category and Scores. Every entity keeps its id.
+		 *
+		 * No other thread may insert names during the call.
+		 */
+		EntityDatabase toEntityDatabase() const;
+
+		private:
+		struct Node;
+		struct Table;
+		struct Shard;
+
+		static const size_t NUM_SHARDS = 64;
+		static const size_t FIRST_CHUNK_BITS = 10;
+		static const size_t FIRST_CHUNK_SIZE = size_t(1) << FIRST_CHUNK_BITS;
+		static const size_t NUM_CHUNKS = 64 - FIRST_CHUNK_BITS;
+
+		/// Returns the chunk and the position in the chunk of id.
+		static void locate_(size_t id, size_t& chunk, size_t& offset);
+
+		/// Returns the node of name or nullptr if it is not contained.
+		const Node* find_(const Shard& shard, NameRef name, size_t hash) const;
+
+		/// Returns the chunk containing id, allocating it if necessary.
+		const Node** chunk_(size_t chunk);
+
+		/// Hands out a new id for node and makes it visible to name().
+		void publish_(Node* node);
+
+		std::unique_ptr<Shard[]> shards_;
+		/// The nodes of all ids. Chunk c holds FIRST_CHUNK_SIZE * 2^c
+		/// nodes, so the chunks cover the whole range of index_type.
+		std::unique_ptr<std::atomic<const Node**>[]> chunks_;
+		/// The next id to hand out.
+		std::atomic<size_t> next_id_;
+		/// All ids below this value have been stored in their chunk.
+		std::atomic<size_t> published_;
+		std::atomic<bool> frozen_;
+	};
+}
+
+#endif // GT2_CORE_CONCURRENT_ENTITY_DATABASE_H
@@ -0,0 +1,133 @@
+/*
+ * GeneTrail2 - An efficient library for interpreting genetic data
+ * Copyright (C) 2016 Daniel Stöckel <dstoeckel@bioinf.uni-sb.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Lesser GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Lesser GNU General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "EntityBitset.h"
+
+#include "Category.h"
+
+#include <algorithm>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace GeneTrail
+{
+	namespace
+	{
+		size_t andCountScalar(const uint64_t* a, const uint64_t* b, size_t n)
+		{
+			size_t count = 0;
+			for(size_t i = 0; i < n; ++i) {
+				count += __builtin_popcountll(a[i] & b[i]);
+			}
+			return count;
+		}
+
+#if defined(__x86_64__)
+		/*
+		 * Counts the bits of a & b, 256 bits at a time. The bytes are
+		 * counted using a 4 bit lookup table via vpshufb and summed up
+		 * using vpsadbw (W. Mula et al., "Faster Population Counts Using
+		 * AVX2 Instructions", 2016).
+		 */
+		__attribute__((target("avx2"))) size_t
+		andCountAVX2(const uint64_t* a, const uint64_t* b, size_t n)
+		{
+			const __m256i lookup =
+			    _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+			                     0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+			const __m256i low_mask = _mm256_set1_epi8(0x0f);
+
+			__m256i acc = _mm256_setzero_si256();
+
+			size_t i = 0;
+			for(; i + 4 <= n; i += 4) {
+				__m256i v = _mm256_and_si256(
+				    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+				    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+
+				__m256i lo = _mm256_and_si256(v, low_mask);
+				__m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+				__m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+				                                _mm256_shuffle_epi8(lookup, hi));
+
+				acc = _mm256_add_epi64(
+				    acc, _mm256_sad_epu8(bytes, _mm256_setzero_si256()));
+			}
+
+			size_t count = static_cast<size_t>(_mm256_extract_epi64(acc, 0)) +
+			               static_cast<size_t>(_mm256_extract_epi64(acc, 1)) +
+			               static_cast<size_t>(_mm256_extract_epi64(acc, 2)) +
+			               static_cast<size_t>(_mm256_extract_epi64(acc, 3));
+
+			return count + andCountScalar(a + i, b + i, n - i);
+		}
+#endif
+
+		size_t andCount(const uint64_t* a, const uint64_t* b, size_t n)
+		{
+#if defined(__x86_64__)
+			static const bool has_avx2 = __builtin_cpu_supports("avx2");
+			if(has_avx2) {
+				return andCountAVX2(a, b, n);
+			}
+#endif
+			return andCountScalar(a, b, n);
+		}
+	}
+
+	EntityBitset::EntityBitset(size_t size)
+	    : size_(size), words_((size + 63) / 64, 0)
+	{
+	}
+
+	EntityBitset::EntityBitset(const Category& c)
+	    : EntityBitset(c.size() == 0 ? 0 : *std::prev(c.end()) + 1)
+	{
+		for(auto i : c) {
+			set(i);
+		}
+	}
+
+	size_t EntityBitset::count() const
+	{
+		size_t count = 0;
+		for(auto word : words_) {
+			count += __builtin_popcountll(word);
+		}
+		return count;
+	}
+
+	size_t EntityBitset::intersectionSize(const Category& c) const
+	{
+		size_t count = 0;
+		for(auto i : c) {
+			count += test(i);
+		}
+		return count;
+	}
+
+	size_t EntityBitset::intersectionSize(const EntityBitset& a,
+	                                      const EntityBitset& b)
+	{
+		return andCount(a.words_.data(), b.words_.data(),
+		                std::min(a.words_.size(), b.words_.size()));
+	}
+}
@@ -0,0 +1,85 @@
+/*
+ * GeneTrail2 - An efficient library for interpreting genetic data
+ * Copyright (C) 2016 Daniel Stöckel <dstoeckel@bioinf.uni-sb.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Lesser GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Lesser GNU General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef GT2_CORE_ENTITY_BITSET_H
+#define GT2_CORE_ENTITY_BITSET_H
+
+#include "macros.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace GeneTrail
+{
+	class Category;
+
+	/**
+	 * A dense set of EntityDatabase ids stored as one bit per id.
+	 *
+	 * Testing the membership of an id costs a single memory access, so
+	 * the intersection size with a category of k entities is computed in
+	 * O(k) without allocating anything. Two bitsets are intersected word
+	 * by word using popcount. On x86-64 CPUs supporting AVX2 this is
+	 * vectorised, which is selected at runtime.
+	 */
+	class GT2_EXPORT EntityBitset
+	{
+		public:
+		EntityBitset() = default;
+
+		/**
+		 * Creates an empty set that can hold the ids [0, size).
+		 */
+		explicit EntityBitset(size_t size);
+
+		/**
+		 * Creates the set of all entities of c.
+		 */
+		explicit EntityBitset(const Category& c);
+
+		/// Adds the id i, which must be smaller than size().
+		void set(size_t i) { words_[i / 64] |= uint64_t(1) << (i % 64); }
+
+		/// Checks whether i is contained. Ids >= size() are never contained.
+		bool test(size_t i) const
+		{
+			return i < size_ && ((words_[i / 64] >> (i % 64)) & 1u);
+		}
+
+		/// The number of ids the set can hold.
+		size_t size() const { return size_; }
+
+		/// The number of ids contained in the set.
+		size_t count() const;
+
+		/// The number of entities of c contained in the set.
+		size_t intersectionSize(const Category& c) const;
+
+		/// The number of ids contained in both a and b.
+		static size_t intersectionSize(const EntityBitset& a,
+		                               const EntityBitset& b);
+
+		private:
+		size_t size_ = 0;
+		std::vector<uint64_t> words_;
+	};
+}
+
+#endif // GT2_CORE_ENTITY_BITSET_H
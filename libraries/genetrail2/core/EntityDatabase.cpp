@@ -21,34 +21,118 @@
 
 #include "Exception.h"
 
+#include <limits>
+#include <stdexcept>
+
 namespace GeneTrail
 {
+	namespace
+	{
+		/// The initial size of the hash table. The table is doubled
+		/// whenever it would become more than half full.
+		const size_t INITIAL_SLOTS = 64;
+	}
+
 	void EntityDatabase::clear()
 	{
-		name_to_index_.clear();
-		db_.clear();
+		arena_.clear();
+		offsets_.assign(1, 0);
+		hashes_.clear();
+		slots_.clear();
+	}
+
+	EntityDatabase::index_type EntityDatabase::hash_(NameRef name)
+	{
+		// 64 bit FNV-1a hash
+		uint64_t hash = 14695981039346656037ull;
+		for(char c : name) {
+			hash ^= static_cast<unsigned char>(c);
+			hash *= 1099511628211ull;
+		}
+
+		// Fold the upper bits into the lower ones, as the hash table
+		// only uses the lower bits of 32 bit hashes.
+		return static_cast<index_type>(hash ^ (hash >> 32));
+	}
+
+	size_t EntityDatabase::findSlot_(NameRef name, index_type hash) const
+	{
+		const size_t mask = slots_.size() - 1;
+
+		for(size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+			const index_type entry = slots_[slot];
+
+			if(entry == 0) {
+				return slot;
+			}
+
+			const index_type id = entry - 1;
+			if(hashes_[id] == hash && this->name(id) == name) {
+				return slot;
+			}
+		}
+	}
+
+	void EntityDatabase::grow_()
+	{
+		std::vector<index_type> slots(
+		    std::max(INITIAL_SLOTS, 2 * slots_.size()), 0);
+		const size_t mask = slots.size() - 1;
+
+		// All names are distinct, so the new positions can be found
+		// from the stored hashes without comparing any names.
+		for(size_t id = 0; id < hashes_.size(); ++id) {
+			size_t slot = hashes_[id] & mask;
+			while(slots[slot] != 0) {
+				slot = (slot + 1) & mask;
+			}
+			slots[slot] = static_cast<index_type>(id + 1);
+		}
+
+		slots_.swap(slots);
 	}
 
-	size_t EntityDatabase::index(const std::string& name)
+	EntityDatabase::index_type EntityDatabase::index(NameRef name)
 	{
-		auto res = name_to_index_.find(name);
+		if(2 * (size() + 1) > slots_.size()) {
+			grow_();
+		}
 
-		if(res == name_to_index_.end()) {
-			res = name_to_index_.emplace(name, db_.size()).first;
-			db_.push_back(name);
+		const index_type hash = hash_(name);
+		const size_t slot = findSlot_(name, hash);
+
+		if(slots_[slot] != 0) {
+			return slots_[slot] - 1;
 		}
 
-		return res->second;
+		// The id plus one needs to fit into a slot and the end of the
+		// name needs to fit into an offset.
+		const index_type max = std::numeric_limits<index_type>::max();
+		if(size() >= max - 1 || name.size() > max - arena_.size()) {
+			throw std::length_error(
+			    "The EntityDatabase cannot store more entities.");
+		}
+
+		const index_type id = static_cast<index_type>(size());
+
+		arena_.insert(arena_.end(), name.begin(), name.end());
+		offsets_.push_back(static_cast<index_type>(arena_.size()));
+		hashes_.push_back(hash);
+		slots_[slot] = id + 1;
+
+		return id;
 	}
 
-	size_t EntityDatabase::index(const std::string& name) const
+	EntityDatabase::index_type EntityDatabase::index(NameRef name) const
 	{
-		auto res = name_to_index_.find(name);
+		if(!slots_.empty()) {
+			const size_t slot = findSlot_(name, hash_(name));
 
-		if(res == name_to_index_.end()) {
-			throw UnknownEntry(name);
+			if(slots_[slot] != 0) {
+				return slots_[slot] - 1;
+			}
 		}
 
-		return res->second;
+		throw UnknownEntry(name.to_string());
 	}
 }
@@ -22,10 +22,15 @@
 #define GT2_ENTITY_DATABASE_H
 
 #include <algorithm>
+#include <cstdint>
 #include <functional>
-#include <unordered_map>
+#include <string>
 #include <vector>
 
+#include <boost/utility/string_ref.hpp>
+
+#include <genetrail2/core/config.h>
+
 #include "macros.h"
 
 namespace GeneTrail
@@ -37,11 +42,37 @@ namespace GeneTrail
 	 * It also provides facilities for converting a range of input strings to
 	 * the respective handles.
 	 *
-	 * @warning Note that the class is currently not thread-safe.
+	 * All names are stored back to back in a single character arena. The
+	 * ids are kept in an open addressing hash table that is probed
+	 * linearly, so a lookup does not allocate and touches at most a few
+	 * contiguous slots. Ids are 32 bit wide unless GeneTrail2 was
+	 * configured with USE_64BIT_ENTITY_IDS.
+	 *
+	 * @warning Note that the class is currently not thread-safe. The
+	 *          enrichment pipeline (see compute() in enrichment/common.cpp)
+	 *          inserts names on one thread while other threads use the ids
+	 *          it already returned. This is fine because ids never change.
+	 *          Those threads must not call any member of the database
+	 *          until the inserting thread has been joined.
 	 */
 	class GT2_EXPORT EntityDatabase
 	{
 		public:
+#ifdef GENETRAIL2_64BIT_ENTITY_IDS
+		using index_type = uint64_t;
+#else
+		using index_type = uint32_t;
+#endif
+		/**
+		 * A view of a name. Views returned by the database point into its
+		 * character arena, which is reallocated when new names are
+		 * inserted. They are invalidated by the next call of the
+		 * non-const index() or operator()(NameRef), by clear(), and by
+		 * destroying or assigning to the database. Copy the name via
+		 * to_string() if it needs to outlive these operations.
+		 */
+		using NameRef = boost::string_ref;
+
 		EntityDatabase() = default;
 		EntityDatabase(const EntityDatabase&) = default;
 		EntityDatabase(EntityDatabase&&) = default;
@@ -55,12 +86,22 @@ namespace GeneTrail
 		void clear();
 
 		/**
-		 * Return the name of instance i
+		 * The number of entities in the database.
+		 */
+		size_t size() const { return hashes_.size(); }
+
+		/**
+		 * Return the name of instance i. See NameRef for how long the
+		 * returned view stays valid.
 		 *
 		 * @param i A valid id of an instance.
 		 * @return The name of the instance.
 		 */
-		const std::string& name(size_t i) const { return db_[i]; }
+		NameRef name(index_type i) const
+		{
+			return NameRef(arena_.data() + offsets_[i],
+			               offsets_[i + 1] - offsets_[i]);
+		}
 
 		/**
 		 * Return the id of an entity. If the entity is not yet known,
@@ -68,8 +109,11 @@ namespace GeneTrail
 		 *
 		 * @param name The name of an entity.
 		 * @return The (possibly new) id of the entity.
+		 *
+		 * @throw std::length_error if the id space or the arena is
+		 *        exhausted.
 		 */
-		size_t index(const std::string& name);
+		index_type index(NameRef name);
 
 		/**
 		 * Return the id of an entity. This is the constant
@@ -80,22 +124,24 @@ namespace GeneTrail
 		 *
 		 * @throw UnkownEntry if the entity is not registered with the database.
 		 */
-		size_t index(const std::string& name) const;
+		index_type index(NameRef name) const;
 
 		/**
-		 * Overload for index(const std::string&)
+		 * Overload for index(NameRef). This invalidates all views
+		 * previously returned by the database if name is inserted.
 		 */
-		size_t operator()(const std::string& name) { return index(name); }
+		index_type operator()(NameRef name) { return index(name); }
 
 		/**
-		 * Overload for index(const std::string&) const
+		 * Overload for index(NameRef) const
 		 */
-		size_t operator()(const std::string& name) const { return index(name); }
+		index_type operator()(NameRef name) const { return index(name); }
 
 		/**
-		 * Overload for name(size_t i) const
+		 * Overload for name(index_type i) const. The view is invalidated
+		 * by the next insertion, see NameRef.
 		 */
-		const std::string& operator()(size_t i) const { return name(i); }
+		NameRef operator()(index_type i) const { return name(i); }
 
 		/**
 		 * Helper function that looks up the entries in the range [a,b) and
@@ -158,8 +204,24 @@ namespace GeneTrail
 		}
 
 		private:
-		std::unordered_map<std::string, size_t> name_to_index_;
-		std::vector<std::string> db_;
+		static index_type hash_(NameRef name);
+
+		/// Returns the slot containing name or the empty slot it belongs to.
+		size_t findSlot_(NameRef name, index_type hash) const;
+
+		void grow_();
+
+		/// The characters of all names.
+		std::vector<char> arena_;
+		/// Name i is stored in arena_[offsets_[i], offsets_[i + 1]). The
+		/// offsets have the width of the ids, which limits the arena to
+		/// 4 GiB of names with 32 bit ids.
+		std::vector<index_type> offsets_ = std::vector<index_type>(1, 0);
+		/// The hash of every name, used for cheap comparisons and rehashing.
+		std::vector<index_type> hashes_;
+		/// The hash table. A slot holds the id of a name plus one or zero
+		/// if it is empty. The size is always a power of two.
+		std::vector<index_type> slots_;
 	};
 }
 
@@ -24,6 +24,8 @@
 #include <memory>
 
 #include <ios>
+#include <istream>
+#include <ostream>
 
 #include "macros.h"
 
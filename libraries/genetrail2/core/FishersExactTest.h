@@ -21,9 +21,13 @@
 #define GT2_CORE_FISHERS_EXACT_TEST_H
 
 #include "macros.h"
+#include "LogFactorialTable.h"
 
 #include <boost/math/special_functions/binomial.hpp>
 
+#include <cmath>
+#include <memory>
+
 namespace GeneTrail
 {
 
@@ -35,6 +39,18 @@ namespace GeneTrail
 	class GT2_EXPORT FishersExactTest
 	{
 		public:
+		FishersExactTest() = default;
+
+		/**
+		 * Uses the given table if m + n does not exceed table->max(). The
+		 * probabilities are then evaluated from double precision
+		 * log-factorials instead of multiprecision binomial coefficients.
+		 */
+		explicit FishersExactTest(std::shared_ptr<const LogFactorialTable> table)
+		    : table_(std::move(table))
+		{
+		}
+
 		/**
 		 * This method implements the Fisher's exact test.
 		 *
@@ -51,6 +67,12 @@ namespace GeneTrail
 		                    const unsigned_integer_type& n,
 		                    const unsigned_integer_type& k) const
 		{
+			if(useTable_(m + n)) {
+				return exp_(table_->logBinomial(n, k) +
+				            table_->logBinomial(m, l) -
+				            table_->logBinomial(m + n, l + k));
+			}
+
 			return (boost::math::binomial_coefficient<return_type>(n, k) *
 			        boost::math::binomial_coefficient<return_type>(m, l)) /
 			        boost::math::binomial_coefficient<return_type>(m + n, l + k);
@@ -74,6 +96,14 @@ namespace GeneTrail
 		                              const unsigned_integer_type& k) const
 		{
 			return_type p = 0;
+
+			if(useTable_(m + n)) {
+				for(unsigned_integer_type i = 0; i <= k; ++i) {
+					p += term_(m, l, n, k, i);
+				}
+				return p;
+			}
+
 			for(unsigned_integer_type i = 0; i <= k; ++i) {
 				p += boost::math::binomial_coefficient<return_type>(n, i) *
 				     boost::math::binomial_coefficient<return_type>(m, l + k - i);
@@ -101,12 +131,51 @@ namespace GeneTrail
 		{
 			return_type p = 0;
 			unsigned_integer_type d = std::min(n, l + k);
+
+			if(useTable_(m + n)) {
+				for(unsigned_integer_type i = k; i <= d; ++i) {
+					p += term_(m, l, n, k, i);
+				}
+				return p;
+			}
+
 			for(unsigned_integer_type i = k; i <= d; ++i) {
 				p += boost::math::binomial_coefficient<return_type>(n, i) *
 				     boost::math::binomial_coefficient<return_type>(m, l + k - i);
 			}
 			return p / boost::math::binomial_coefficient<return_type>(m + n, l + k);
 		}
+
+		private:
+		bool useTable_(const unsigned_integer_type& mn) const
+		{
+			return table_ && mn <= table_->max();
+		}
+
+		/// The probability of i successes, which is zero if the
+		/// remaining draws exceed m.
+		return_type term_(const unsigned_integer_type& m,
+		                  const unsigned_integer_type& l,
+		                  const unsigned_integer_type& n,
+		                  const unsigned_integer_type& k,
+		                  const unsigned_integer_type& i) const
+		{
+			if(l + k - i > m) {
+				return 0;
+			}
+
+			return exp_(table_->logBinomial(n, i) +
+			            table_->logBinomial(m, l + k - i) -
+			            table_->logBinomial(m + n, l + k));
+		}
+
+		static return_type exp_(double x)
+		{
+			using std::exp;
+			return exp(return_type(x));
+		}
+
+		std::shared_ptr<const LogFactorialTable> table_;
 	};
 }
 
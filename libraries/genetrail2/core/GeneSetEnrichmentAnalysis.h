@@ -26,6 +26,7 @@
 #include "Category.h"
 
 #include <boost/math/special_functions/binomial.hpp>
+#include <boost/optional.hpp>
 
 #include <functional>
 #include <map>
@@ -34,6 +35,7 @@
 #include <cmath>
 #include <cstdint>
 #include <algorithm>
+#include <array>
 #include <utility>
 #include <tuple>
 
@@ -106,8 +108,10 @@ namespace GeneTrail
 			size_t l = std::distance(begin, end);
 			size_t nl = n - l;
 
-			big_int_type RSc = *begin * l;
-			big_int_type rs = -RSc;
+			// The running sum drops by l for every gene in front of the
+			// first category member.
+			big_int_type rs = -static_cast<big_int_type>(*begin * l);
+			big_int_type RSc = rs;
 
 			rs += nl;
 
@@ -128,6 +132,83 @@ namespace GeneTrail
 			return RSc;
 		}
 
+		/**
+		 * Scratch memory for computeRunningSums. Reusing one instance for
+		 * all blocks avoids allocating the state of the running sums for
+		 * every call.
+		 */
+		struct RunningSumBuffers
+		{
+			std::vector<big_int_type> RSc;
+			std::vector<big_int_type> rs;
+			std::vector<big_int_type> lastIndex;
+		};
+
+		/**
+		 * Batched version of computeRunningSum(n, begin, end). Computes the
+		 * running sum statistic for a block of sorted index ranges that all
+		 * have the same length l. The state of the running sums is kept in
+		 * a structure of arrays and the ranges are advanced in lock step, so
+		 * that the inner loop is free of data dependent branches and can be
+		 * vectorised by the compiler.
+		 *
+		 * @param n      The total number of genes.
+		 * @param begins Iterators pointing to the beginning of the ranges.
+		 * @param l      The number of indices in every range.
+		 * @param out    Output iterator receiving the maximum value of the
+		 *               running sum for every range.
+		 * @param buffers Scratch memory holding the state of the running
+		 *                sums. It must not be shared between threads.
+		 */
+		template <typename Iterator, typename OutputIterator>
+		void computeRunningSums(size_t n, const std::vector<Iterator>& begins,
+		                        size_t l, OutputIterator out,
+		                        RunningSumBuffers& buffers)
+		{
+			const size_t numRanges = begins.size();
+
+			if(l == 0) {
+				std::fill_n(out, numRanges, big_int_type(0));
+				return;
+			}
+
+			const big_int_type bl = l;
+			const big_int_type nl = n - l;
+
+			// Only grows the buffers; their contents are overwritten below.
+			buffers.RSc.resize(numRanges);
+			buffers.rs.resize(numRanges);
+			buffers.lastIndex.resize(numRanges);
+
+			auto RSc = buffers.RSc.data();
+			auto rs = buffers.rs.data();
+			auto lastIndex = buffers.lastIndex.data();
+
+			for(size_t b = 0; b < numRanges; ++b) {
+				lastIndex[b] = begins[b][0];
+				RSc[b] = -lastIndex[b] * bl;
+				rs[b] = RSc[b] + nl;
+				RSc[b] = absMax(RSc[b], rs[b]);
+			}
+
+			for(size_t k = 1; k < l; ++k) {
+				for(size_t b = 0; b < numRanges; ++b) {
+					const big_int_type index = begins[b][k];
+					rs[b] -= (index - lastIndex[b] - 1) * bl;
+					RSc[b] = absMax(RSc[b], rs[b]);
+					rs[b] += nl;
+					RSc[b] = absMax(RSc[b], rs[b]);
+					lastIndex[b] = index;
+				}
+			}
+
+			for(size_t b = 0; b < numRanges; ++b) {
+				rs[b] -= (big_int_type(n) - lastIndex[b] - 1) * bl;
+				*out = absMax(RSc[b], rs[b]);
+				++out;
+			}
+		}
+
 		/**
 		 * This method computes the running sum statistic and the corresponding
 		 * p-value, based on the given categories.
@@ -159,6 +240,10 @@ namespace GeneTrail
 		float_type computeTwoSidedPValue(const size_t& n, const size_t& l,
 		                                 const big_int_type& RSc)
 		{
+			if(auto p = computeBandPValue_(n, l, abs(RSc), true, true)) {
+				return *p;
+			}
+
 			return computePValue_(
 			    n, l, abs(RSc),
 			    [](big_int_type v, big_int_type RSc) { return abs(v) < RSc; });
@@ -177,6 +262,10 @@ namespace GeneTrail
 		                             const big_int_type& RSc)
 		{
 			assert(n >= l);
+			if(auto p = computeBandPValue_(n, l, std::abs(RSc), true, false)) {
+				return *p;
+			}
+
 			return computePValue_(
 			    n, l, std::abs(RSc),
 			    [](big_int_type v, big_int_type RSc) { return -RSc < v; });
@@ -195,11 +284,89 @@ namespace GeneTrail
 		                              const big_int_type& RSc)
 		{
 			assert(n >= l);
+			if(auto p = computeBandPValue_(n, l, std::abs(RSc), false, true)) {
+				return *p;
+			}
+
 			return computePValue_(
 			    n, l, std::abs(RSc),
 			    [](big_int_type v, big_int_type RSc) { return v < RSc; });
 		}
 
+		/**
+		 * Computes computeTwoSidedPValue for several running sum statistics
+		 * of categories with the same number of genes l. The statistics are
+		 * evaluated in blocks that share a single pass of the dynamic
+		 * programming. Sorting the statistics beforehand improves the
+		 * efficiency, as similar statistics visit similar cells.
+		 *
+		 * @param n The number of genes in the test set
+		 * @param l The number of genes in the category
+		 * @param RScs The running sum statistics
+		 * @return The p-values in the order of RScs
+		 */
+		std::vector<float_type>
+		computeTwoSidedPValues(const size_t& n, const size_t& l,
+		                       const std::vector<big_int_type>& RScs)
+		{
+			return computePValues_(
+			    n, l, RScs, true, true,
+			    [](big_int_type v, big_int_type RSc) { return abs(v) < RSc; });
+		}
+
+		/**
+		 * Computes computeLeftPValue for several running sum statistics.
+		 * See computeTwoSidedPValues.
+		 */
+		std::vector<float_type>
+		computeLeftPValues(const size_t& n, const size_t& l,
+		                   const std::vector<big_int_type>& RScs)
+		{
+			assert(n >= l);
+			return computePValues_(
+			    n, l, RScs, true, false,
+			    [](big_int_type v, big_int_type RSc) { return -RSc < v; });
+		}
+
+		/**
+		 * Computes computeRightPValue for several running sum statistics.
+		 * See computeTwoSidedPValues.
+		 */
+		std::vector<float_type>
+		computeRightPValues(const size_t& n, const size_t& l,
+		                    const std::vector<big_int_type>& RScs)
+		{
+			assert(n >= l);
+			return computePValues_(
+			    n, l, RScs, false, true,
+			    [](big_int_type v, big_int_type RSc) { return v < RSc; });
+		}
+
+		template <typename Comparator>
+		std::vector<float_type>
+		computePValues_(const size_t n, const size_t l,
+		                const std::vector<big_int_type>& RScs, bool lower,
+		                bool upper, Comparator comp)
+		{
+			using std::abs;
+
+			std::vector<big_int_type> abs_RScs(RScs.size());
+			for(size_t i = 0; i < RScs.size(); ++i) {
+				abs_RScs[i] = abs(RScs[i]);
+			}
+
+			auto band = computeBandPValues_(n, l, abs_RScs.data(),
+			                                abs_RScs.size(), lower, upper);
+
+			std::vector<float_type> result(RScs.size());
+			for(size_t i = 0; i < RScs.size(); ++i) {
+				result[i] =
+				    band[i] ? *band[i] : computePValue_(n, l, abs_RScs[i], comp);
+			}
+
+			return result;
+		}
+
 		/**
 		 * Internal routine for the pvalue computation.
 		 * It implements the dynamic programming recursion.
@@ -272,6 +439,282 @@ namespace GeneTrail
 			return 1.0 - M[nl] / binom;
 		}
 
+		/**
+		 * Double precision version of computePValue_ for the comparators
+		 * -RSc < v (lower), v < RSc (upper), or both.
+		 *
+		 * Instead of counting the lattice paths, this propagates the
+		 * probability of a uniformly drawn path to reach a cell without
+		 * leaving the allowed band. From cell (i, k) the path continues to
+		 * (i + 1, k) with probability (l - i) / (l - i + n - l - k) and to
+		 * (i, k + 1) otherwise. The probability mass that steps out of the
+		 * band is accumulated, which directly yields the p-value as a sum of
+		 * positive terms. This avoids the cancellation in 1 - M / binom and
+		 * thus keeps the relative accuracy of small p-values.
+		 *
+		 * As v = i * (n - l) - k * l decreases in k, the allowed cells of a
+		 * column form an interval whose bounds do not decrease with i. Only
+		 * the cells in this interval are visited, which reduces the cost
+		 * from O(l * (n - l)) to the number of cells inside the band.
+		 *
+		 * @return boost::none for degenerate inputs or if the p-value is too
+		 *         small to be represented in double precision. Then the
+		 *         multiprecision version must be used.
+		 */
+		boost::optional<float_type> computeBandPValue_(const size_t n,
+		                                               const size_t l,
+		                                               const big_int_type& RSc,
+		                                               bool lower, bool upper)
+		{
+			const int64_t nl = n - l;
+
+			if(l == 0 || nl == 0) {
+				return boost::none;
+			}
+
+			const int64_t il = l;
+			const int64_t R = static_cast<int64_t>(RSc);
+
+			// The interval of allowed k in column i. The upper bound of v
+			// yields the lower bound of k and vice versa.
+			auto band = [&](int64_t i, int64_t& lo, int64_t& hi) {
+				lo = upper ? floorDiv_(i * nl - R, il) + 1 : 0;
+				hi = lower ? ceilDiv_(i * nl + R, il) - 1 : nl;
+				lo = std::max<int64_t>(lo, 0);
+				hi = std::min<int64_t>(hi, nl);
+			};
+
+			std::vector<double> inv(n + 1);
+			for(size_t j = 1; j <= n; ++j) {
+				inv[j] = 1.0 / j;
+			}
+
+			std::vector<double> P(nl + 1, 0.0);
+			double exit = 0.0;
+
+			// The start is always allowed, as in computePValue_.
+			P[0] = 1.0;
+
+			int64_t lo, hi;
+			band(0, lo, hi);
+			int64_t first = 0;
+			int64_t last = std::max<int64_t>(hi, 0);
+
+			for(int64_t i = 0; i <= il; ++i) {
+				const int64_t r = il - i;
+
+				int64_t next_lo = 0, next_hi = nl;
+				if(r > 0) {
+					band(i + 1, next_lo, next_hi);
+				}
+
+				// P holds the mass entering from the previous column, carry
+				// the mass entering from the cell below. Keeping the latter
+				// in a register shortens the dependency chain of the pass.
+				double carry = 0.0;
+				for(int64_t k = first; k <= last; ++k) {
+					const int64_t u = nl - k;
+					const double mass = P[k] + carry;
+					const double inv_ru = inv[r + u];
+
+					carry = mass * (u * inv_ru);
+					if(k + 1 < lo || k + 1 > hi) {
+						exit += carry;
+						carry = 0.0;
+					}
+
+					const double flow = mass * (r * inv_ru);
+					if(k >= next_lo) {
+						P[k] = flow;
+					} else {
+						P[k] = 0.0;
+						exit += flow;
+					}
+				}
+
+				if(r == 0) {
+					break;
+				}
+
+				lo = next_lo;
+				hi = next_hi;
+				first = std::max(first, lo);
+				last = hi;
+
+				if(first > last) {
+					// No path stays within the band.
+					return float_type(1.0);
+				}
+			}
+
+			if(exit < 1e-280) {
+				return boost::none;
+			}
+
+			return float_type(std::min(1.0, exit));
+		}
+
+		/**
+		 * Version of computeBandPValue_ that computes the p-values of
+		 * numThresholds running sum statistics. The thresholds are processed
+		 * in blocks of BAND_LANES, each with a single pass over the lattice.
+		 * The probabilities of a block are stored interleaved, so the update
+		 * of a cell is a loop over independent lanes. This hides the latency
+		 * of the sequential recurrence along a column and allows the
+		 * compiler to vectorise the update. The result for every threshold
+		 * is identical to the one of computeBandPValue_.
+		 */
+		std::vector<boost::optional<float_type>>
+		computeBandPValues_(const size_t n, const size_t l,
+		                    const big_int_type* RScs, size_t numThresholds,
+		                    bool lower, bool upper)
+		{
+			std::vector<boost::optional<float_type>> result(numThresholds);
+
+			if(l == 0 || l == n) {
+				return result;
+			}
+
+			for(size_t b = 0; b < numThresholds; b += BAND_LANES) {
+				std::array<int64_t, BAND_LANES> R;
+				const size_t remaining = numThresholds - b;
+				const size_t T =
+				    remaining < BAND_LANES ? remaining : BAND_LANES;
+				for(size_t t = 0; t < BAND_LANES; ++t) {
+					// Unused lanes repeat the last threshold.
+					R[t] = static_cast<int64_t>(RScs[b + std::min(t, T - 1)]);
+				}
+
+				auto pvalues = computeBandBlock_(n, l, R, lower, upper);
+				std::copy(pvalues.begin(), pvalues.begin() + T,
+				          result.begin() + b);
+			}
+
+			return result;
+		}
+
+		constexpr static size_t BAND_LANES = 4;
+
+		std::array<boost::optional<float_type>, BAND_LANES>
+		computeBandBlock_(const size_t n, const size_t l,
+		                  const std::array<int64_t, BAND_LANES>& R, bool lower,
+		                  bool upper)
+		{
+			constexpr size_t T = BAND_LANES;
+			const int64_t nl = n - l;
+			const int64_t il = l;
+
+			// The interval of allowed k in column i. The upper bound of v
+			// yields the lower bound of k and vice versa.
+			auto band = [&](int64_t i, int64_t R, int64_t& lo, int64_t& hi) {
+				lo = upper ? floorDiv_(i * nl - R, il) + 1 : 0;
+				hi = lower ? ceilDiv_(i * nl + R, il) - 1 : nl;
+				lo = std::max<int64_t>(lo, 0);
+				hi = std::min<int64_t>(hi, nl);
+			};
+
+			std::vector<double> inv(n + 1);
+			for(size_t j = 1; j <= n; ++j) {
+				inv[j] = 1.0 / j;
+			}
+
+			std::array<int64_t, T> lo, hi, next_lo, next_hi;
+			std::array<double, T> exit, carry;
+			std::array<bool, T> empty;
+			std::vector<double> P((nl + 1) * T, 0.0);
+
+			int64_t first = 0;
+			int64_t last = 0;
+			for(size_t t = 0; t < T; ++t) {
+				band(0, R[t], lo[t], hi[t]);
+				last = std::max(last, hi[t]);
+				exit[t] = 0.0;
+				empty[t] = false;
+				// The start is always allowed, as in computePValue_.
+				P[t] = 1.0;
+			}
+
+			for(int64_t i = 0; i <= il; ++i) {
+				const int64_t r = il - i;
+
+				for(size_t t = 0; t < T; ++t) {
+					next_lo[t] = 0;
+					next_hi[t] = nl;
+					if(r > 0) {
+						band(i + 1, R[t], next_lo[t], next_hi[t]);
+					}
+				}
+
+				// P holds the mass entering from the previous column, carry
+				// the mass entering from the cell below.
+				carry.fill(0.0);
+				for(int64_t k = first; k <= last; ++k) {
+					const int64_t u = nl - k;
+					const double up_weight = u * inv[r + u];
+					const double right_weight = r * inv[r + u];
+					double* Pk = P.data() + k * T;
+
+					for(size_t t = 0; t < T; ++t) {
+						const double mass = Pk[t] + carry[t];
+
+						const double up = mass * up_weight;
+						const bool out = k + 1 < lo[t] || k + 1 > hi[t];
+						exit[t] += out ? up : 0.0;
+						carry[t] = out ? 0.0 : up;
+
+						const double flow = mass * right_weight;
+						const bool keep = k >= next_lo[t];
+						Pk[t] = keep ? flow : 0.0;
+						exit[t] += keep ? 0.0 : flow;
+					}
+				}
+
+				if(r == 0) {
+					break;
+				}
+
+				first = nl;
+				last = 0;
+				for(size_t t = 0; t < T; ++t) {
+					lo[t] = next_lo[t];
+					hi[t] = next_hi[t];
+
+					// If the band is empty, no path stays within it.
+					empty[t] = empty[t] || lo[t] > hi[t];
+
+					if(!empty[t]) {
+						first = std::min(first, lo[t]);
+						last = std::max(last, hi[t]);
+					}
+				}
+
+				if(first > last) {
+					break;
+				}
+			}
+
+			std::array<boost::optional<float_type>, T> result;
+			for(size_t t = 0; t < T; ++t) {
+				if(empty[t]) {
+					result[t] = float_type(1.0);
+				} else if(exit[t] >= 1e-280) {
+					result[t] = float_type(std::min(1.0, exit[t]));
+				}
+			}
+
+			return result;
+		}
+
+		static int64_t floorDiv_(int64_t a, int64_t b)
+		{
+			return a / b - (a % b != 0 && a < 0);
+		}
+
+		static int64_t ceilDiv_(int64_t a, int64_t b)
+		{
+			return a / b + (a % b != 0 && a > 0);
+		}
+
 		/**
 		 * This method computes the running sum statistic and the corresponding
 		 *p-value, based on the given categories.
@@ -0,0 +1,201 @@
+/*
+ * GeneTrail2 - An efficient library for interpreting genetic data
+ * Copyright (C) 2016 Daniel Stöckel <dstoeckel@bioinf.uni-sb.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Lesser GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Lesser GNU General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "HypergeometricDistribution.h"
+
+#include "LogFactorialTable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace GeneTrail
+{
+namespace hypergeometric
+{
+	namespace
+	{
+		struct LogGammaBinomial
+		{
+			double operator()(uint64_t a, uint64_t b) const
+			{
+				return std::lgamma(a + 1.0) - std::lgamma(b + 1.0) -
+				       std::lgamma(a - b + 1.0);
+			}
+		};
+
+		struct TableBinomial
+		{
+			double operator()(uint64_t a, uint64_t b) const
+			{
+				return table.logBinomial(a, b);
+			}
+
+			const LogFactorialTable& table;
+		};
+
+		// The range of k for which the probability is not zero.
+		uint64_t support_min(uint64_t m, uint64_t l, uint64_t n)
+		{
+			return n > m - l ? n + l - m : 0;
+		}
+
+		uint64_t support_max(uint64_t l, uint64_t n) { return std::min(n, l); }
+
+		uint64_t mode(uint64_t m, uint64_t l, uint64_t n)
+		{
+			return static_cast<uint64_t>(std::floor((n + 1.0) * (l + 1.0) /
+			                                        (m + 2.0)));
+		}
+
+		template <typename LogBinomial>
+		double logProbability_(LogBinomial logBinomial, uint64_t m,
+		                       uint64_t l, uint64_t n, uint64_t k)
+		{
+			if(k < support_min(m, l, n) || k > support_max(l, n)) {
+				return -std::numeric_limits<double>::infinity();
+			}
+
+			return logBinomial(l, k) + logBinomial(m - l, n - k) -
+			       logBinomial(m, n);
+		}
+
+		/*
+		 * Sums the probabilities of [first, support_max] or
+		 * [support_min, first] depending on upper. The terms must decrease
+		 * monotonically in the direction of summation, i.e. first must not
+		 * lie on the other side of the mode.
+		 */
+		template <typename LogBinomial>
+		boost::optional<double> sumTail(LogBinomial logBinomial, uint64_t m,
+		                                uint64_t l, uint64_t n, uint64_t first,
+		                                bool upper)
+		{
+			double term =
+			    std::exp(logProbability_(logBinomial, m, l, n, first));
+
+			if(term < std::numeric_limits<double>::min()) {
+				return boost::none;
+			}
+
+			const double eps = std::numeric_limits<double>::epsilon();
+			double p = term;
+
+			if(upper) {
+				const uint64_t last = support_max(l, n);
+				for(uint64_t i = first; i < last && term > eps * p; ++i) {
+					term *= static_cast<double>(l - i) * (n - i) /
+					        ((i + 1.0) * (m - l - n + i + 1.0));
+					p += term;
+				}
+			} else {
+				const uint64_t last = support_min(m, l, n);
+				for(uint64_t i = first; i > last && term > eps * p; --i) {
+					term *= static_cast<double>(i) * (m - l - n + i) /
+					        ((l - i + 1.0) * (n - i + 1.0));
+					p += term;
+				}
+			}
+
+			return std::min(1.0, p);
+		}
+
+		template <typename LogBinomial>
+		boost::optional<double> lowerTail_(LogBinomial logBinomial,
+		                                   uint64_t m, uint64_t l, uint64_t n,
+		                                   uint64_t k)
+		{
+			if(k >= support_max(l, n)) {
+				return 1.0;
+			}
+
+			if(k < support_min(m, l, n)) {
+				return 0.0;
+			}
+
+			if(k < mode(m, l, n)) {
+				return sumTail(logBinomial, m, l, n, k, false);
+			}
+
+			// The upper tail starting at k + 1 does not contain the mode.
+			auto complement = sumTail(logBinomial, m, l, n, k + 1, true);
+			return std::max(0.0, 1.0 - complement.value_or(0.0));
+		}
+
+		template <typename LogBinomial>
+		boost::optional<double> upperTail_(LogBinomial logBinomial,
+		                                   uint64_t m, uint64_t l, uint64_t n,
+		                                   uint64_t k)
+		{
+			if(k <= support_min(m, l, n)) {
+				return 1.0;
+			}
+
+			if(k > support_max(l, n)) {
+				return 0.0;
+			}
+
+			if(k > mode(m, l, n)) {
+				return sumTail(logBinomial, m, l, n, k, true);
+			}
+
+			// The lower tail ending at k - 1 does not contain the mode.
+			auto complement = sumTail(logBinomial, m, l, n, k - 1, false);
+			return std::max(0.0, 1.0 - complement.value_or(0.0));
+		}
+	}
+
+	double logProbability(uint64_t m, uint64_t l, uint64_t n, uint64_t k)
+	{
+		return logProbability_(LogGammaBinomial(), m, l, n, k);
+	}
+
+	double logProbability(const LogFactorialTable& table, uint64_t m,
+	                      uint64_t l, uint64_t n, uint64_t k)
+	{
+		return logProbability_(TableBinomial{table}, m, l, n, k);
+	}
+
+	boost::optional<double> lowerTail(uint64_t m, uint64_t l, uint64_t n,
+	                                  uint64_t k)
+	{
+		return lowerTail_(LogGammaBinomial(), m, l, n, k);
+	}
+
+	boost::optional<double> lowerTail(const LogFactorialTable& table,
+	                                  uint64_t m, uint64_t l, uint64_t n,
+	                                  uint64_t k)
+	{
+		return lowerTail_(TableBinomial{table}, m, l, n, k);
+	}
+
+	boost::optional<double> upperTail(uint64_t m, uint64_t l, uint64_t n,
+	                                  uint64_t k)
+	{
+		return upperTail_(LogGammaBinomial(), m, l, n, k);
+	}
+
+	boost::optional<double> upperTail(const LogFactorialTable& table,
+	                                  uint64_t m, uint64_t l, uint64_t n,
+	                                  uint64_t k)
+	{
+		return upperTail_(TableBinomial{table}, m, l, n, k);
+	}
+}
+}
@@ -0,0 +1,91 @@
+/*
+ * GeneTrail2 - An efficient library for interpreting genetic data
+ * Copyright (C) 2016 Daniel Stöckel <dstoeckel@bioinf.uni-sb.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Lesser GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Lesser GNU General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef GT2_CORE_HYPERGEOMETRIC_DISTRIBUTION_H
+#define GT2_CORE_HYPERGEOMETRIC_DISTRIBUTION_H
+
+#include "macros.h"
+
+#include <boost/optional.hpp>
+
+#include <cstdint>
+
+namespace GeneTrail
+{
+	class LogFactorialTable;
+
+	/**
+	 * Double precision evaluation of the hypergeometric distribution.
+	 *
+	 * The parameters follow the convention of HypergeometricTest:
+	 * m is the population size, l the number of success states in the
+	 * population, n the number of draws and k the number of successes.
+	 *
+	 * The tails are evaluated starting from the term that is farthest
+	 * from the mode. Only this term is computed from log-factorials, all
+	 * other terms are derived from their neighbour by a single
+	 * multiplication. Tails that contain the mode are computed via their
+	 * complement. As the terms decrease monotonically, the summation can
+	 * stop as soon as they no longer contribute to the sum.
+	 *
+	 * All functions optionally accept a LogFactorialTable, which must
+	 * contain the factorials up to m!. Otherwise, the log-factorials are
+	 * computed using std::lgamma.
+	 *
+	 * If the first term underflows, the tail cannot be represented
+	 * accurately as a normalised double and boost::none is returned. The
+	 * caller should then fall back to a multiprecision implementation such
+	 * as HypergeometricTest.
+	 */
+	namespace hypergeometric
+	{
+		/**
+		 * The natural logarithm of the probability to observe exactly k
+		 * successes.
+		 */
+		GT2_EXPORT double logProbability(uint64_t m, uint64_t l, uint64_t n,
+		                                 uint64_t k);
+
+		GT2_EXPORT double logProbability(const LogFactorialTable& table,
+		                                 uint64_t m, uint64_t l, uint64_t n,
+		                                 uint64_t k);
+
+		/**
+		 * The probability to observe at most k successes.
+		 */
+		GT2_EXPORT boost::optional<double>
+		lowerTail(uint64_t m, uint64_t l, uint64_t n, uint64_t k);
+
+		GT2_EXPORT boost::optional<double>
+		lowerTail(const LogFactorialTable& table, uint64_t m, uint64_t l,
+		          uint64_t n, uint64_t k);
+
+		/**
+		 * The probability to observe at least k successes.
+		 */
+		GT2_EXPORT boost::optional<double>
+		upperTail(uint64_t m, uint64_t l, uint64_t n, uint64_t k);
+
+		GT2_EXPORT boost::optional<double>
+		upperTail(const LogFactorialTable& table, uint64_t m, uint64_t l,
+		          uint64_t n, uint64_t k);
+	}
+}
+
+#endif // GT2_CORE_HYPERGEOMETRIC_DISTRIBUTION_H
@@ -22,9 +22,13 @@
 #define GT2_CORE_HYPERGEOMETRIC_TEST_H
 
 #include "macros.h"
+#include "LogFactorialTable.h"
 
 #include <boost/math/special_functions/binomial.hpp>
+
+#include <cmath>
 #include <iostream>
+#include <memory>
 
 namespace GeneTrail
 {
@@ -36,6 +40,19 @@ namespace GeneTrail
 	class GT2_EXPORT HypergeometricTest
 	{
 		public:
+		HypergeometricTest() = default;
+
+		/**
+		 * Uses the given table for all populations of at most table->max()
+		 * genes. The probabilities are then evaluated from double precision
+		 * log-factorials instead of multiprecision binomial coefficients.
+		 */
+		explicit HypergeometricTest(
+		    std::shared_ptr<const LogFactorialTable> table)
+		    : table_(std::move(table))
+		{
+		}
+
 		/**
 		 * This method implements the Hypergeometric test.
 		 *
@@ -49,6 +66,12 @@ namespace GeneTrail
 		return_type compute(const uintt& m, const uintt& l, const uintt& n,
 		                    const uintt& k) const
 		{
+			if(useTable_(m)) {
+				return exp_(table_->logBinomial(l, k) +
+				            table_->logBinomial(m - l, n - k) -
+				            table_->logBinomial(m, n));
+			}
+
 			return (boost::math::binomial_coefficient<return_type>(l, k) *
 			        boost::math::binomial_coefficient<return_type>(m - l, n - k)) /
 			       boost::math::binomial_coefficient<return_type>(m, n);
@@ -71,6 +94,16 @@ namespace GeneTrail
 			return_type p = 0.0;
 			// Make sure we do not compute undefined binomial coefficients
 			uintt i = (n > m - l) ? (n + l) - m : 0; // Brackets are here to avoid underrun
+
+			if(useTable_(m)) {
+				const double logNorm = table_->logBinomial(m, n);
+				for(; i <= k; ++i) {
+					p += exp_(table_->logBinomial(l, i) +
+					          table_->logBinomial(m - l, n - i) - logNorm);
+				}
+				return p;
+			}
+
 			for(; i <= k; ++i) {
 				p += boost::math::binomial_coefficient<return_type>(l, i) *
 				     boost::math::binomial_coefficient<return_type>(m - l, n - i);
@@ -94,12 +127,36 @@ namespace GeneTrail
 		{
 			return_type p = 0.0;
 			uintt d = std::min(n, l);
+
+			if(useTable_(m)) {
+				const double logNorm = table_->logBinomial(m, n);
+				for(uintt i = k; i <= d; ++i) {
+					p += exp_(table_->logBinomial(l, i) +
+					          table_->logBinomial(m - l, n - i) - logNorm);
+				}
+				return p;
+			}
+
 			for(uintt i = k; i <= d; ++i) {
 				p += boost::math::binomial_coefficient<return_type>(l, i) *
 				     boost::math::binomial_coefficient<return_type>(m - l, n - i);
 			}
 			return p / boost::math::binomial_coefficient<return_type>(m, n);
 		}
+
+		private:
+		bool useTable_(const uintt& m) const
+		{
+			return table_ && m <= table_->max();
+		}
+
+		static return_type exp_(double x)
+		{
+			using std::exp;
+			return exp(return_type(x));
+		}
+
+		std::shared_ptr<const LogFactorialTable> table_;
 	};
 }
 
@@ -52,20 +52,11 @@ namespace GeneTrail {
 		 */
 		template<typename InputIterator1, typename InputIterator2>
 		std::vector<value_type> test(InputIterator1 begin_first, InputIterator1 end_first, InputIterator2 begin_second, InputIterator2 end_second){
-			std::vector<value_type> t_scores;
 			std::vector<Gene<value_type>> genes_first, genes_second;
 			value_type var_median_first, var_median_second;
 			std::tie(genes_first, var_median_first) = this->computeAllVariances(begin_first, end_first);
 			std::tie(genes_second, var_median_second) = this->computeAllVariances(begin_second, end_second);
-			this->computePooledVariances(genes_first, var_median_first);
-			this->computePooledVariances(genes_second, var_median_second);
-
-			for(unsigned int i=0; i<genes_first.size(); ++i){
-				auto* a = &genes_first[i];
-				auto* b = &genes_second[i];
-				t_scores.emplace_back((a->mean - b->mean) / std::sqrt( a->shrink_var/a->size + b->shrink_var/b->size ));
-			}
-			return t_scores;
+			return tScores_(genes_first, var_median_first, genes_second, var_median_second);
 		}
 
 		/**
@@ -79,14 +70,52 @@ namespace GeneTrail {
 		 */
 		template<typename InputIterator1, typename InputIterator2>
 		std::vector<value_type> testRemoveNaN(InputIterator1 begin_first, InputIterator1 end_first, InputIterator2 begin_second, InputIterator2 end_second){
-			std::vector<value_type> t_scores;
 			std::vector<Gene<value_type>> genes_first, genes_second;
 			value_type var_median_first, var_median_second;
 			std::tie(genes_first, var_median_first) = this->computeAllVariancesRemoveNaN(begin_first, end_first);
 			std::tie(genes_second, var_median_second) = this->computeAllVariancesRemoveNaN(begin_second, end_second);
+			return tScores_(genes_first, var_median_first, genes_second, var_median_second);
+		}
+
+		/**
+		 * Computes the shrinkage t-statistic for each row of the given
+		 * matrices. The columns of the matrices must be accessible as
+		 * contiguous Eigen vectors via col(j).
+		 *
+		 * @param first Matrix containing the first group
+		 * @param second Matrix containing the second group
+		 * @param numThreads The number of threads to use
+		 * @return Vector of t-scores
+		 */
+		template<typename Matrix>
+		std::vector<value_type> testRows(const Matrix& first, const Matrix& second, size_t numThreads = 1){
+			std::vector<Gene<value_type>> genes_first, genes_second;
+			value_type var_median_first, var_median_second;
+			std::tie(genes_first, var_median_first) = this->computeRowVariances(first, numThreads);
+			std::tie(genes_second, var_median_second) = this->computeRowVariances(second, numThreads);
+			return tScores_(genes_first, var_median_first, genes_second, var_median_second);
+		}
+
+		/**
+		 * Same as testRows, but skips NaN values.
+		 */
+		template<typename Matrix>
+		std::vector<value_type> testRowsRemoveNaN(const Matrix& first, const Matrix& second, size_t numThreads = 1){
+			std::vector<Gene<value_type>> genes_first, genes_second;
+			value_type var_median_first, var_median_second;
+			std::tie(genes_first, var_median_first) = this->computeRowVariancesRemoveNaN(first, numThreads);
+			std::tie(genes_second, var_median_second) = this->computeRowVariancesRemoveNaN(second, numThreads);
+			return tScores_(genes_first, var_median_first, genes_second, var_median_second);
+		}
+
+		private:
+		std::vector<value_type> tScores_(std::vector<Gene<value_type>>& genes_first, value_type var_median_first,
+		                                 std::vector<Gene<value_type>>& genes_second, value_type var_median_second){
 			this->computePooledVariances(genes_first, var_median_first);
 			this->computePooledVariances(genes_second, var_median_second);
 
+			std::vector<value_type> t_scores;
+			t_scores.reserve(genes_first.size());
 			for(unsigned int i=0; i<genes_first.size(); ++i){
 				auto* a = &genes_first[i];
 				auto* b = &genes_second[i];
@@ -62,6 +62,19 @@ namespace GeneTrail {
 			std::tie(mean1, var1, size1) = statistic::mean_var_size<value_type>(first_begin, first_end);
 			std::tie(mean2, var2, size2) = statistic::mean_var_size<value_type>(second_begin, second_end);
 
+			return test(mean1, var1, size1, mean2, var2, size2);
+		}
+
+		/**
+		 * Computes the t-score from the means, the sample variances and
+		 * the sizes of both groups. This is useful if these sufficient
+		 * statistics can be obtained without iterating over the groups.
+		 *
+		 * @return t-score for the differences between the two groups
+		 */
+		value_type test(value_type mean1, value_type var1, size_t size1,
+		                value_type mean2, value_type var2, size_t size2)
+		{
 			auto stdErr1_2 = var1 / size1;
 			auto stdErr2_2 = var2 / size2;
 			auto stdErr_2 = stdErr1_2 + stdErr2_2;
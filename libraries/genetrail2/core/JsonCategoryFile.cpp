@@ -26,6 +26,8 @@
 
 #include <cassert>
 #include <cstring>
+#include <istream>
+#include <ostream>
 
 namespace GeneTrail
 {
@@ -266,9 +268,9 @@ static void buildDatabase(const rapidjson::Document& document,
 	readCategories(document["categories"], database);
 }
 
-static void writeString(Writer& writer, const std::string& key)
+static void writeString(Writer& writer, boost::string_ref key)
 {
-	writer.String(key.c_str(), key.size());
+	writer.String(key.data(), key.size());
 }
 
 class MetadataWriter: public boost::static_visitor<void>
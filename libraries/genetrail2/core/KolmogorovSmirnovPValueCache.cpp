@@ -0,0 +1,226 @@
+/*
+ * GeneTrail2 - An efficient library for interpreting genetic data
+ * Copyright (C) 2016 Daniel Stöckel <dstoeckel@bioinf.uni-sb.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Lesser GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Lesser GNU General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "KolmogorovSmirnovPValueCache.h"
+
+#include "Exception.h"
+#include "GeneSetEnrichmentAnalysis.h"
+#include "ReplacingFileWriter.h"
+#include "multiprecision.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <tuple>
+
+namespace GeneTrail
+{
+	namespace
+	{
+		const char MAGIC[8] = {'G', 'T', '2', 'K', 'S', 'P', 'V', '1'};
+
+		using Side = KolmogorovSmirnovPValueCache::Side;
+
+		std::vector<double> computePValues(size_t n, size_t l,
+		                                   const std::vector<int64_t>& RScs,
+		                                   Side side)
+		{
+			GeneSetEnrichmentAnalysis<big_float, int64_t> gsea;
+
+			std::vector<big_float> pvalues;
+			switch(side) {
+				case Side::Left:
+					pvalues = gsea.computeLeftPValues(n, l, RScs);
+					break;
+				case Side::Right:
+					pvalues = gsea.computeRightPValues(n, l, RScs);
+					break;
+				case Side::TwoSided:
+					pvalues = gsea.computeTwoSidedPValues(n, l, RScs);
+					break;
+			}
+
+			std::vector<double> result(pvalues.size());
+			for(size_t i = 0; i < pvalues.size(); ++i) {
+				result[i] = pvalues[i].convert_to<double>();
+			}
+
+			return result;
+		}
+	}
+
+	bool KolmogorovSmirnovPValueCache::Key::operator<(const Key& o) const
+	{
+		return std::tie(n, l, side, RSc) < std::tie(o.n, o.l, o.side, o.RSc);
+	}
+
+	double KolmogorovSmirnovPValueCache::pValue(size_t n, size_t l,
+	                                            int64_t RSc, Side side)
+	{
+		const Key key{n, l, std::abs(RSc), side};
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			auto it = pvalues_.find(key);
+			if(it != pvalues_.end()) {
+				return it->second;
+			}
+		}
+
+		// The lock is not held during the computation, so other threads
+		// can use the cache in the meantime. If two threads compute the
+		// same p-value, both obtain the same result.
+		const double pvalue = computePValues(n, l, {key.RSc}, side)[0];
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		pvalues_.emplace(key, pvalue);
+
+		return pvalue;
+	}
+
+	void KolmogorovSmirnovPValueCache::precompute(size_t n, size_t l,
+	                                              std::vector<int64_t> RScs,
+	                                              Side side)
+	{
+		for(auto& RSc : RScs) {
+			RSc = std::abs(RSc);
+		}
+
+		// Neighbouring statistics visit similar cells of the lattice, so
+		// sorting them improves the efficiency of the batches.
+		std::sort(RScs.begin(), RScs.end());
+		RScs.erase(std::unique(RScs.begin(), RScs.end()), RScs.end());
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			RScs.erase(std::remove_if(RScs.begin(), RScs.end(),
+			                          [&](int64_t RSc) {
+				                          return pvalues_.count(
+				                                     Key{n, l, RSc, side}) > 0;
+				                      }),
+			           RScs.end());
+		}
+
+		if(RScs.empty()) {
+			return;
+		}
+
+		auto pvalues = computePValues(n, l, RScs, side);
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		for(size_t i = 0; i < RScs.size(); ++i) {
+			pvalues_.emplace(Key{n, l, RScs[i], side}, pvalues[i]);
+		}
+	}
+
+	size_t KolmogorovSmirnovPValueCache::size() const
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		return pvalues_.size();
+	}
+
+	void KolmogorovSmirnovPValueCache::write(const std::string& path) const
+	{
+		// Other processes may read the file at the same time, so it must
+		// not be truncated in place.
+		ReplacingFileWriter writer(path);
+		auto& strm = writer.stream();
+
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		uint64_t size = pvalues_.size();
+		strm.write(MAGIC, sizeof(MAGIC));
+		strm.write(reinterpret_cast<const char*>(&size), sizeof(size));
+
+		for(const auto& entry : pvalues_) {
+			strm.write(reinterpret_cast<const char*>(&entry.first),
+			           sizeof(entry.first));
+			strm.write(reinterpret_cast<const char*>(&entry.second),
+			           sizeof(entry.second));
+		}
+
+		if(!strm) {
+			throw IOError("Could not write p-values to '" + path + "'.");
+		}
+
+		writer.commit();
+	}
+
+	void KolmogorovSmirnovPValueCache::read(const std::string& path)
+	{
+		std::ifstream strm(path, std::ios::binary);
+
+		if(!strm) {
+			throw IOError("Could not open '" + path + "' for reading.");
+		}
+
+		char magic[sizeof(MAGIC)];
+		uint64_t size = 0;
+		strm.read(magic, sizeof(magic));
+		strm.read(reinterpret_cast<char*>(&size), sizeof(size));
+
+		if(!strm || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) {
+			throw IOError("'" + path + "' is not a p-value cache file.");
+		}
+
+		// Bound the number of entries by the file length before reserving
+		// memory, so that a corrupt header cannot request a huge buffer.
+		const auto headerEnd = strm.tellg();
+		strm.seekg(0, std::ios::end);
+		const uint64_t remaining = strm.tellg() - headerEnd;
+		strm.seekg(headerEnd);
+
+		const size_t entrySize = sizeof(Key) + sizeof(double);
+		if(size > remaining / entrySize) {
+			throw IOError("The p-value cache file '" + path +
+			              "' is truncated.");
+		}
+
+		std::vector<std::pair<Key, double>> entries;
+		entries.reserve(size);
+		for(uint64_t i = 0; i < size; ++i) {
+			std::pair<Key, double> entry;
+			strm.read(reinterpret_cast<char*>(&entry.first),
+			          sizeof(entry.first));
+			strm.read(reinterpret_cast<char*>(&entry.second),
+			          sizeof(entry.second));
+
+			if(!strm) {
+				throw IOError("The p-value cache file '" + path +
+				              "' is truncated.");
+			}
+
+			const auto& key = entry.first;
+			const auto side = static_cast<uint64_t>(key.side);
+			const double p = entry.second;
+			if(side > static_cast<uint64_t>(Side::TwoSided) || key.n < key.l ||
+			   !std::isfinite(p) || p < 0.0 || p > 1.0) {
+				throw IOError("The p-value cache file '" + path +
+				              "' is corrupt.");
+			}
+
+			entries.push_back(entry);
+		}
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		pvalues_.insert(entries.begin(), entries.end());
+	}
+}
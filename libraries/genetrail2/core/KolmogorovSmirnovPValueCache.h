@@ -0,0 +1,98 @@
+/*
+ * GeneTrail2 - An efficient library for interpreting genetic data
+ * Copyright (C) 2016 Daniel Stöckel <dstoeckel@bioinf.uni-sb.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Lesser GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Lesser GNU General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef GT2_CORE_KOLMOGOROV_SMIRNOV_PVALUE_CACHE_H
+#define GT2_CORE_KOLMOGOROV_SMIRNOV_PVALUE_CACHE_H
+
+#include "macros.h"
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace GeneTrail
+{
+	/**
+	 * Memoises the exact p-values of the unweighted running sum statistic.
+	 *
+	 * The p-value only depends on the number of genes n, the number of
+	 * hits l, the running sum statistic RSc, and the side of the test.
+	 * In a typical run many categories share these parameters, so every
+	 * p-value only needs to be computed once. Statistics for the same n
+	 * and l can further be computed in batches that share the dynamic
+	 * programming over the lattice.
+	 *
+	 * All methods are thread safe. The cache can be written to disk and
+	 * read again, so that it can be kept across multiple runs.
+	 */
+	class GT2_EXPORT KolmogorovSmirnovPValueCache
+	{
+		public:
+		enum class Side : uint64_t { Left = 0, Right = 1, TwoSided = 2 };
+
+		/**
+		 * Returns the p-value for the given parameters. The p-value is
+		 * computed if it is not contained in the cache yet.
+		 */
+		double pValue(size_t n, size_t l, int64_t RSc, Side side);
+
+		/**
+		 * Computes the p-values of all given statistics that are not
+		 * contained in the cache yet. All statistics belong to categories
+		 * with l hits out of n genes.
+		 */
+		void precompute(size_t n, size_t l, std::vector<int64_t> RScs,
+		                Side side);
+
+		/// The number of cached p-values.
+		size_t size() const;
+
+		/**
+		 * Writes all cached p-values to the given file.
+		 *
+		 * @throws IOError if the file cannot be written.
+		 */
+		void write(const std::string& path) const;
+
+		/**
+		 * Adds the p-values stored in the given file to the cache.
+		 *
+		 * @throws IOError if the file cannot be read or is invalid.
+		 */
+		void read(const std::string& path);
+
+		private:
+		struct Key
+		{
+			uint64_t n;
+			uint64_t l;
+			int64_t RSc;
+			Side side;
+
+			bool operator<(const Key& o) const;
+		};
+
+		mutable std::mutex mutex_;
+		std::map<Key, double> pvalues_;
+	};
+}
+
+#endif // GT2_CORE_KOLMOGOROV_SMIRNOV_PVALUE_CACHE_H
@@ -0,0 +1,150 @@
+/*
+ * GeneTrail2 - An efficient library for interpreting genetic data
+ * Copyright (C) 2016 Daniel Stöckel <dstoeckel@bioinf.uni-sb.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Lesser GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Lesser GNU General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "LogFactorialTable.h"
+
+#include "Exception.h"
+#include "ReplacingFileWriter.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+
+namespace GeneTrail
+{
+	namespace
+	{
+		const char MAGIC[8] = {'G', 'T', '2', 'L', 'F', 'A', 'C', '1'};
+
+		std::mutex table_mutex;
+		std::shared_ptr<const LogFactorialTable> shared_table;
+		std::string cache_directory;
+	}
+
+	LogFactorialTable::LogFactorialTable(size_t n) : values_(n + 1)
+	{
+		// Using lgamma for every entry avoids the accumulation of
+		// rounding errors of a running sum of logarithms.
+		for(size_t i = 0; i <= n; ++i) {
+			values_[i] = std::lgamma(i + 1.0);
+		}
+	}
+
+	void LogFactorialTable::write(const std::string& path) const
+	{
+		// Concurrent runs share the cache directory, so a table must
+		// never be visible while it is only partially written.
+		ReplacingFileWriter writer(path);
+		auto& strm = writer.stream();
+
+		uint64_t size = values_.size();
+		strm.write(MAGIC, sizeof(MAGIC));
+		strm.write(reinterpret_cast<const char*>(&size), sizeof(size));
+		strm.write(reinterpret_cast<const char*>(values_.data()),
+		           size * sizeof(double));
+
+		if(!strm) {
+			throw IOError("Could not write log factorials to '" + path + "'.");
+		}
+
+		writer.commit();
+	}
+
+	LogFactorialTable LogFactorialTable::read(const std::string& path)
+	{
+		std::ifstream strm(path, std::ios::binary);
+
+		if(!strm) {
+			throw IOError("Could not open '" + path + "' for reading.");
+		}
+
+		char magic[sizeof(MAGIC)];
+		uint64_t size = 0;
+		strm.read(magic, sizeof(magic));
+		strm.read(reinterpret_cast<char*>(&size), sizeof(size));
+
+		if(!strm || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 ||
+		   size == 0) {
+			throw IOError("'" + path + "' is not a log factorial file.");
+		}
+
+		LogFactorialTable result;
+		result.values_.resize(size);
+		strm.read(reinterpret_cast<char*>(result.values_.data()),
+		          size * sizeof(double));
+
+		if(!strm) {
+			throw IOError("The log factorial file '" + path +
+			              "' is truncated.");
+		}
+
+		return result;
+	}
+
+	static std::shared_ptr<const LogFactorialTable>
+	loadOrCompute(size_t n, const std::string& directory)
+	{
+		if(directory.empty()) {
+			return std::make_shared<const LogFactorialTable>(n);
+		}
+
+		const std::string path =
+		    directory + "/log_factorials_" + std::to_string(n) + ".bin";
+
+		try {
+			auto table = LogFactorialTable::read(path);
+			if(table.max() >= n) {
+				return std::make_shared<const LogFactorialTable>(
+				    std::move(table));
+			}
+		} catch(IOError&) {
+			// The table is not cached yet or the file is damaged.
+		}
+
+		auto table = std::make_shared<const LogFactorialTable>(n);
+
+		try {
+			table->write(path);
+		} catch(IOError&) {
+			// The cache is only an optimisation, so we can continue
+			// without writing it.
+		}
+
+		return table;
+	}
+
+	std::shared_ptr<const LogFactorialTable> LogFactorialTable::get(size_t n)
+	{
+		std::lock_guard<std::mutex> lock(table_mutex);
+
+		if(!shared_table || shared_table->max() < n) {
+			shared_table = loadOrCompute(n, cache_directory);
+		}
+
+		return shared_table;
+	}
+
+	void LogFactorialTable::setCacheDirectory(const std::string& directory)
+	{
+		std::lock_guard<std::mutex> lock(table_mutex);
+		cache_directory = directory;
+	}
+}
@@ -0,0 +1,103 @@
+/*
+ * GeneTrail2 - An efficient library for interpreting genetic data
+ * Copyright (C) 2016 Daniel Stöckel <dstoeckel@bioinf.uni-sb.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Lesser GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Lesser GNU General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef GT2_CORE_LOG_FACTORIAL_TABLE_H
+#define GT2_CORE_LOG_FACTORIAL_TABLE_H
+
+#include "macros.h"
+
+#include <cassert>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace GeneTrail
+{
+	/**
+	 * A table of the natural logarithms of the factorials 0!, ..., n!.
+	 *
+	 * The binomial coefficients needed by the hypergeometric and Fisher's
+	 * exact test are bounded by the size of the reference set, which is
+	 * fixed for a whole run. With this table, every binomial coefficient
+	 * costs three lookups. The table is immutable after construction and
+	 * can thus be shared between threads.
+	 */
+	class GT2_EXPORT LogFactorialTable
+	{
+		public:
+		/**
+		 * Computes the table for the factorials up to n!.
+		 */
+		explicit LogFactorialTable(size_t n);
+
+		/// The largest n for which log(n!) is contained.
+		size_t max() const { return values_.size() - 1; }
+
+		/// log(i!)
+		double logFactorial(size_t i) const
+		{
+			assert(i < values_.size());
+			return values_[i];
+		}
+
+		/// The logarithm of the binomial coefficient n over k.
+		double logBinomial(size_t n, size_t k) const
+		{
+			assert(k <= n);
+			return logFactorial(n) - logFactorial(k) - logFactorial(n - k);
+		}
+
+		/**
+		 * Writes the table to the given file.
+		 *
+		 * @throws IOError if the file cannot be written.
+		 */
+		void write(const std::string& path) const;
+
+		/**
+		 * Reads a table that was written using write().
+		 *
+		 * @throws IOError if the file cannot be read or is invalid.
+		 */
+		static LogFactorialTable read(const std::string& path);
+
+		/**
+		 * Returns a table containing at least the factorials up to n!.
+		 *
+		 * All callers share the largest table requested so far. If a cache
+		 * directory has been set, tables are read from and written to that
+		 * directory, so that subsequent processes do not need to recompute
+		 * them.
+		 */
+		static std::shared_ptr<const LogFactorialTable> get(size_t n);
+
+		/**
+		 * Sets the directory in which get() caches its tables. An empty
+		 * string disables the cache, which is the default.
+		 */
+		static void setCacheDirectory(const std::string& directory);
+
+		private:
+		LogFactorialTable() = default;
+
+		std::vector<double> values_;
+	};
+}
+
+#endif // GT2_CORE_LOG_FACTORIAL_TABLE_H
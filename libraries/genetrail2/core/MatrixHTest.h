@@ -22,6 +22,8 @@
 #define GT2_CORE_MATRIX_HTEST_H
 
 #include "HTest.h"
+#include "DenseColumnSubset.h"
+#include "DenseMatrix.h"
 #include "FTest.h"
 #include "IndependentTTest.h"
 #include "DependentTTest.h"
@@ -32,6 +34,8 @@
 #include "SignalToNoiseRatio.h"
 #include "MatrixIterator.h"
 #include "GeneSet.h"
+#include "RowMedians.h"
+#include "RowMoments.h"
 #include "Scores.h"
 
 #include "macros.h"
@@ -39,7 +43,9 @@
 #include <boost/iterator/filter_iterator.hpp>
 #include <boost/iterator/transform_iterator.hpp>
 #include <boost/iterator/zip_iterator.hpp>
+#include <boost/optional.hpp>
 
+#include <algorithm>
 #include <vector>
 #include <utility>
 #include <iterator>
@@ -48,6 +54,8 @@
 #include <set>
 #include <functional>
 #include <tuple>
+#include <unordered_map>
+#include <type_traits>
 #include <initializer_list>
 #include <cassert>
 #include <cmath>
@@ -331,10 +339,13 @@ namespace GeneTrail
 			double test(Iterator1 fst_begin, Iterator1 fst_end,
 			            Iterator2 snd_begin, Iterator2 snd_end) const override
 			{
-				WilcoxonRankSumTest<double> test;
-				return HTest::test(test, fst_begin, fst_end, snd_begin,
+				return HTest::test(test_, fst_begin, fst_end, snd_begin,
 				                   snd_end);
 			}
+
+			// Reused for all rows, so its scratch space is only allocated
+			// once.
+			mutable WilcoxonRankSumTest<double> test_;
 		};
 
 		template <class Iterator1, class Iterator2>
@@ -378,9 +389,12 @@ namespace GeneTrail
 			double test(Iterator1 fst_begin, Iterator1 fst_end,
 			            Iterator2 snd_begin, Iterator2 snd_end) const override
 			{
-				return statistic::log_median_fold_quotient<double>(
-				    fst_begin, fst_end, snd_begin, snd_end);
+				return statistic::log_median_fold_quotient(
+				    fst_begin, fst_end, snd_begin, snd_end, buffer_);
 			}
+
+			// Scratch space that is reused for all rows.
+			mutable std::vector<double> buffer_;
 		};
 
 		template <class Iterator1, class Iterator2>
@@ -411,9 +425,12 @@ namespace GeneTrail
 			double test(Iterator1 fst_begin, Iterator1 fst_end,
 			            Iterator2 snd_begin, Iterator2 snd_end) const override
 			{
-				return statistic::median_fold_quotient<double>(
-				    fst_begin, fst_end, snd_begin, snd_end);
+				return statistic::median_fold_quotient(
+				    fst_begin, fst_end, snd_begin, snd_end, buffer_);
 			}
+
+			// Scratch space that is reused for all rows.
+			mutable std::vector<double> buffer_;
 		};
 
 		template <class Iterator1, class Iterator2>
@@ -422,9 +439,12 @@ namespace GeneTrail
 			double test(Iterator1 fst_begin, Iterator1 fst_end,
 			            Iterator2 snd_begin, Iterator2 snd_end) const override
 			{
-				return statistic::median_fold_difference<double>(
-				    fst_begin, fst_end, snd_begin, snd_end);
+				return statistic::median_fold_difference(
+				    fst_begin, fst_end, snd_begin, snd_end, buffer_);
 			}
+
+			// Scratch space that is reused for all rows.
+			mutable std::vector<double> buffer_;
 		};
 
 		template <class Iterator1, class Iterator2>
@@ -438,7 +458,7 @@ namespace GeneTrail
 				std::vector<double> a(fst_begin, fst_end);
 				a.insert(a.end(), snd_begin, snd_end);
 				std::vector<double> b(a.size(), 0.0);
-				std::fill(b.begin() + n, a.end(), 1.0);
+				std::fill(b.begin() + n, b.end(), 1.0);
 
 				return statistic::pearson_correlation<double>(
 				    a.begin(), a.end(), b.begin(), b.end());
@@ -453,14 +473,29 @@ namespace GeneTrail
 			{
 				const auto n = std::distance(fst_begin, fst_end);
 
-				std::vector<double> a(fst_begin, fst_end);
-				a.insert(a.end(), snd_begin, snd_end);
-				std::vector<double> b(a.size(), 0.0);
-				std::fill(b.begin() + n, a.end(), 1.0);
+				values_.assign(fst_begin, fst_end);
+				values_.insert(values_.end(), snd_begin, snd_end);
+				groups_.assign(values_.size(), 0.0);
+				std::fill(groups_.begin() + n, groups_.end(), 1.0);
 
-				return statistic::spearman_correlation<double>(
-				    a.begin(), a.end(), b.begin(), b.end());
+				value_ranks_.resize(values_.size());
+				group_ranks_.resize(values_.size());
+				statistic::ranks(values_.begin(), values_.end(),
+				                 value_ranks_.begin(), order_);
+				statistic::ranks(groups_.begin(), groups_.end(),
+				                 group_ranks_.begin(), order_);
+
+				return statistic::pearson_correlation<double>(
+				    value_ranks_.begin(), value_ranks_.end(),
+				    group_ranks_.begin(), group_ranks_.end());
 			}
+
+			// Scratch space that is reused for all rows.
+			mutable std::vector<double> values_;
+			mutable std::vector<double> groups_;
+			mutable std::vector<double> value_ranks_;
+			mutable std::vector<double> group_ranks_;
+			mutable std::vector<size_t> order_;
 		};
 
 		template <class Iterator1, class Iterator2>
@@ -482,6 +517,25 @@ namespace GeneTrail
 		bool descriptorsProperlyInitialized_() const;
 	};
 
+	/**
+	 * True for the matrix types whose columns are contiguous Eigen vectors
+	 * that can be accessed via col(j).
+	 */
+	template <typename Matrix>
+	struct HasContiguousColumns : public std::false_type
+	{
+	};
+
+	template <>
+	struct HasContiguousColumns<DenseMatrix> : public std::true_type
+	{
+	};
+
+	template <>
+	struct HasContiguousColumns<DenseColumnSubset> : public std::true_type
+	{
+	};
+
 	class MatrixHTest
 	{
 		public:
@@ -489,6 +543,14 @@ namespace GeneTrail
 			row_db_indices_ = row_db_indices;
 		}
 
+		/**
+		 * Sets the number of threads used by tests that process all rows
+		 * at once. The default is one thread.
+		 */
+		void setNumberOfThreads(size_t num_threads) {
+			num_threads_ = std::max<size_t>(1, num_threads);
+		}
+
 		template <typename Matrix>
 		Scores test(const std::string& method, const Matrix& ref,
 		            const Matrix& sam, NanMode mode = NanMode::Ignore)
@@ -506,6 +568,7 @@ namespace GeneTrail
 		private:
 		MatrixHTestFactory factory;
 		std::vector<size_t> row_db_indices_;
+		size_t num_threads_ = 1;
 
 		template <typename Matrix>
 		Scores test_(const MatrixHTestFactory::MethodDescriptor& descriptor,
@@ -674,6 +737,12 @@ namespace GeneTrail
 			auto db = std::make_shared<EntityDatabase>();
 			Scores scores(ref.rows(), db);
 
+			if(auto v = testRows_(descriptor.id, ref, sam, RemoveNaN(),
+			                      HasContiguousColumns<Matrix>())) {
+				assignScores_(scores, *v, ref);
+				return scores;
+			}
+
 			RowMajorMatrixIterator<Matrix> ref_begin(&ref, 0),
 			    ref_end(&ref, ref.rows()), sam_begin(&sam, 0),
 			    sam_end(&sam, sam.rows());
@@ -700,6 +769,18 @@ namespace GeneTrail
 			auto db = std::make_shared<EntityDatabase>();
 			Scores scores(ref.rows(), db);
 
+			if(auto v = testMoments_(descriptor.id, ref, sam,
+			                         HasContiguousColumns<Matrix>())) {
+				assignScores_(scores, *v, ref);
+				return scores;
+			}
+
+			if(auto v = testMedians_(descriptor.id, ref, sam,
+			                         HasContiguousColumns<Matrix>())) {
+				assignScores_(scores, *v, ref);
+				return scores;
+			}
+
 			RowMajorMatrixIterator<Matrix> ref_it(&ref, 0), sam_it(&sam, 0);
 
 			using Iterator1 = decltype(ref_it->begin());
@@ -729,6 +810,12 @@ namespace GeneTrail
 			auto db = std::make_shared<EntityDatabase>();
 			Scores scores(ref.rows(), db);
 
+			if(auto v = testRows_(descriptor.id, ref, sam, IgnoreNaN(),
+			                      HasContiguousColumns<Matrix>())) {
+				assignScores_(scores, *v, ref);
+				return scores;
+			}
+
 			RowMajorMatrixIterator<Matrix> ref_begin(&ref, 0),
 			    ref_end(&ref, ref.rows()), sam_begin(&sam, 0),
 			    sam_end(&sam, sam.rows());
@@ -746,6 +833,166 @@ namespace GeneTrail
 			return scores;
 		}
 
+		template <typename Matrix>
+		boost::optional<std::vector<double>>
+		testMoments_(MatrixHTests, const Matrix&, const Matrix&,
+		             std::false_type) const
+		{
+			return boost::none;
+		}
+
+		/**
+		 * Computes the statistics that only depend on the means and the
+		 * variances of the rows for all rows at once. The moments are
+		 * computed with column-wise reductions over contiguous memory,
+		 * which avoids the per-row iterator adaptors and virtual calls of
+		 * the generic path.
+		 *
+		 * @return The scores of all rows or boost::none if the method is
+		 *         not based on moments.
+		 */
+		template <typename Matrix>
+		boost::optional<std::vector<double>>
+		testMoments_(MatrixHTests method, const Matrix& ref, const Matrix& sam,
+		             std::true_type) const
+		{
+			// The tolerances of IndependentTTest and DependentTTest.
+			const double tolerance = 1e-5;
+
+			if(ref.cols() == 0 || sam.cols() == 0) {
+				return boost::none;
+			}
+
+			Eigen::ArrayXd result;
+			switch(method) {
+				case MatrixHTests::IndependentTTest: {
+					auto a = rowMoments(ref);
+					auto b = rowMoments(sam);
+					Eigen::ArrayXd std_err =
+					    (a.var / double(a.n) + b.var / double(b.n)).sqrt();
+					result = (std_err < tolerance)
+					             .select(0.0, (a.mean - b.mean) / std_err);
+					break;
+				}
+				case MatrixHTests::DependentTTest: {
+					// Let the generic path report mismatching groups.
+					if(ref.cols() != sam.cols()) {
+						return boost::none;
+					}
+					auto d = rowDifferenceMoments(ref, sam);
+					Eigen::ArrayXd var_n = d.var / double(d.n);
+					result = (var_n.abs() < tolerance)
+					             .select(0.0, d.mean / var_n.sqrt());
+					break;
+				}
+				case MatrixHTests::FTest: {
+					result = rowMoments(ref).var / rowMoments(sam).var;
+					break;
+				}
+				case MatrixHTests::SignalToNoiseRatio: {
+					auto a = rowMoments(ref);
+					auto b = rowMoments(sam);
+					result =
+					    (a.mean - b.mean) / (a.var.sqrt() + b.var.sqrt());
+					break;
+				}
+				case MatrixHTests::MeanFoldQuotient:
+					result = rowMoments(ref).mean / rowMoments(sam).mean;
+					break;
+				case MatrixHTests::MeanFoldDifference:
+					result = rowMoments(ref).mean - rowMoments(sam).mean;
+					break;
+				case MatrixHTests::ZScore: {
+					auto b = rowMoments(sam);
+					result = (ref.col(0).array() - b.mean) / b.var.sqrt();
+					break;
+				}
+				default:
+					return boost::none;
+			}
+
+			return std::vector<double>(result.data(),
+			                           result.data() + result.size());
+		}
+
+		template <typename Matrix>
+		boost::optional<std::vector<double>>
+		testMedians_(MatrixHTests, const Matrix&, const Matrix&,
+		             std::false_type) const
+		{
+			return boost::none;
+		}
+
+		/**
+		 * Computes the statistics that only depend on the medians of the
+		 * rows from the medians of all rows, which are selected in one
+		 * blocked pass over each matrix.
+		 *
+		 * @return The scores of all rows or boost::none if the method is
+		 *         not based on medians.
+		 */
+		template <typename Matrix>
+		boost::optional<std::vector<double>>
+		testMedians_(MatrixHTests method, const Matrix& ref,
+		             const Matrix& sam, std::true_type) const
+		{
+			Eigen::ArrayXd result;
+			switch(method) {
+				case MatrixHTests::LogMedianFoldQuotient: {
+					// std::log instead of the vectorised Eigen logarithm
+					// keeps the results identical to the per-row test.
+					auto log = [](double x) { return std::log(x); };
+					result = rowMedians(ref).unaryExpr(log) -
+					         rowMedians(sam).unaryExpr(log);
+					break;
+				}
+				case MatrixHTests::MedianFoldQuotient:
+					result = rowMedians(ref) / rowMedians(sam);
+					break;
+				case MatrixHTests::MedianFoldDifference:
+					result = rowMedians(ref) - rowMedians(sam);
+					break;
+				default:
+					return boost::none;
+			}
+
+			return std::vector<double>(result.data(),
+			                           result.data() + result.size());
+		}
+
+		template <typename Matrix, typename NaNStrategy>
+		boost::optional<std::vector<double>>
+		testRows_(MatrixHTests, const Matrix&, const Matrix&, NaNStrategy,
+		          std::false_type) const
+		{
+			return boost::none;
+		}
+
+		/**
+		 * Computes the vectorized tests directly on the columns of the
+		 * matrices. The rows are processed in blocks, which are
+		 * distributed over num_threads_ threads.
+		 *
+		 * @return The scores of all rows or boost::none if the method has
+		 *         no column-wise implementation.
+		 */
+		template <typename Matrix, typename NaNStrategy>
+		boost::optional<std::vector<double>>
+		testRows_(MatrixHTests method, const Matrix& ref, const Matrix& sam,
+		          NaNStrategy, std::true_type) const
+		{
+			if(method != MatrixHTests::IndependentShrinkageTTest) {
+				return boost::none;
+			}
+
+			IndependentShrinkageTTest<double> test;
+			if(std::is_same<NaNStrategy, RemoveNaN>::value) {
+				return test.testRowsRemoveNaN(ref, sam, num_threads_);
+			}
+
+			return test.testRows(ref, sam, num_threads_);
+		}
+
 		template<typename Matrix>
 		void assignScores_(Scores& scores, const std::vector<typename Matrix::value_type>& v, const Matrix& ref) const {
 			if(row_db_indices_.empty()) {
@@ -61,37 +61,30 @@ namespace GeneTrail {
         template<typename InputIterator>
         value_type test(const InputIterator& begin, const InputIterator& end) {
 
-			std::vector<value_type> diff(begin, end);
-
-            for (auto it=diff.begin(); it != diff.end(); ++it) {
-                *it -= mu_;
-            }
-
-			std::vector< std::pair< value_type, int> > ranks;
-			for(unsigned int i=0; i<diff.size(); ++i){
-				if(diff[i] >= 0){
-					ranks.push_back(std::make_pair(diff[i], 1));
-				}else{
-					ranks.push_back(std::make_pair(-diff[i], -1));
-				}
+			diff_.assign(begin, end);
+
+			// The absolute differences are ranked in decreasing order, so
+			// the largest difference receives rank 1.
+			keys_.resize(diff_.size());
+			for(size_t i = 0; i < diff_.size(); ++i) {
+				diff_[i] -= mu_;
+				keys_[i] = -std::abs(diff_[i]);
 			}
 
-			sort(ranks.begin(), ranks.end(),
-				[](const std::pair< value_type, int>& a, const std::pair< value_type, int>& b) {
-					return b.first < a.first;
-				});
+			ranks_.resize(diff_.size());
+			statistic::ranks(keys_.begin(), keys_.end(), ranks_.begin(),
+			                 order_);
 
 			value_type p_rank_sum = 0.0;
 			value_type n_rank_sum = 0.0;
 
-
-            for (unsigned int i = 0; i < ranks.size(); ++i) {
-                if (ranks[i].second == 1) {
-                    p_rank_sum += i+1;
-                } else {
-                    n_rank_sum += i+1;
-                }
-            }
+			for(size_t i = 0; i < diff_.size(); ++i) {
+				if(diff_[i] >= 0) {
+					p_rank_sum += ranks_[i];
+				} else {
+					n_rank_sum += ranks_[i];
+				}
+			}
 
 			value_type rank_sum = 0.0;
 			if(p_rank_sum < n_rank_sum){
@@ -101,7 +94,7 @@ namespace GeneTrail {
 				rank_sum = n_rank_sum;
 			}
 
-			score_ = (rank_sum - mean(diff.size())) / var(diff.size());
+			score_ = (rank_sum - mean(diff_.size())) / var(diff_.size());
 
             return score_;
         }
@@ -125,6 +118,13 @@ namespace GeneTrail {
         value_type tolerance_;
 		value_type score_;
 		value_type mu_;
+
+		// Scratch space of test(), kept to avoid allocations in repeated
+		// calls.
+		std::vector<value_type> diff_;
+		std::vector<value_type> keys_;
+		std::vector<double> ranks_;
+		std::vector<size_t> order_;
     };
 }
 
@@ -19,16 +19,28 @@
  */
 #include "OverRepresentationAnalysis.h"
 
+#include "HypergeometricDistribution.h"
+
+#include <cmath>
+#include <limits>
+
 using namespace GeneTrail;
 
 OverRepresentationAnalysis::OverRepresentationAnalysis(
     const Category& reference_set, const Category& test_set)
-    : reference_set_(reference_set), test_set_(test_set)
+    : reference_set_(reference_set),
+      test_set_(test_set),
+      reference_bits_(reference_set),
+      test_bits_(test_set)
 {
 	m_ = reference_set_.size();
 	n_ = test_set_.size();
 	useHypergeometricTest_ =
 	    categoryContainsAllGenes(reference_set_, test_set_);
+
+	table_ = LogFactorialTable::get(m_ + n_);
+	fisherTest_ = FishersExactTest<uint64_t, big_float>(table_);
+	hyperTest_ = HypergeometricTest<uint64_t, big_float>(table_);
 }
 
 bool
@@ -45,11 +57,11 @@ OverRepresentationAnalysis::categoryContainsAllGenes(const Category& reference,
 }
 
 double OverRepresentationAnalysis::numberOfHits(const Category& category) const {
-	return static_cast<double>(Category::intersect("null", category, test_set_).size());
+	return static_cast<double>(test_bits_.intersectionSize(category));
 }
 
 double OverRepresentationAnalysis::expectedNumberOfHits(const Category& category) const {
-	auto l = Category::intersect("null", category, reference_set_).size();
+	auto l = reference_bits_.intersectionSize(category);
 	return (l * n_) / static_cast<double>(m_);
 }
 
@@ -58,25 +70,48 @@ double OverRepresentationAnalysis::computePValue(const Category& category) const
 	// GeneTrail 1
 	// size_t l = category.size();
 
-	size_t k = Category::intersect("null", category, test_set_).size();
-	size_t l = Category::intersect("null", category, reference_set_).size();
+	size_t k = test_bits_.intersectionSize(category);
+	size_t l = reference_bits_.intersectionSize(category);
 
-	auto expected_k = ((double)l * n_) / ((double)m_);
+	return computePValue(table_, m_, l, n_, k, useHypergeometricTest_);
+}
+
+double OverRepresentationAnalysis::computePValue(
+    const std::shared_ptr<const LogFactorialTable>& table, size_t m, size_t l,
+    size_t n, size_t k, bool useHypergeometricTest)
+{
+	auto expected_k = ((double)l * n) / ((double)m);
 	bool enriched = expected_k < k;
 
+	// Fisher's exact test is a hypergeometric test on the union of the
+	// reference and the test set.
+	const auto& t = *table;
+	auto fast = useHypergeometricTest
+	                ? (enriched ? hypergeometric::upperTail(t, m, l, n, k)
+	                            : hypergeometric::lowerTail(t, m, l, n, k))
+	                : (enriched ? hypergeometric::upperTail(t, m + n, n, l + k, k)
+	                            : hypergeometric::lowerTail(t, m + n, n, l + k, k));
+
+	if(fast) {
+		return *fast;
+	}
+
+	// The p-value is too small for double precision arithmetic.
 	big_float p;
 
-	if(useHypergeometricTest_) {
+	if(useHypergeometricTest) {
+		HypergeometricTest<uint64_t, big_float> hyperTest(table);
 		if(enriched) {
-			p = hyperTest_.upperTailedPValue(m_, l, n_, k);
+			p = hyperTest.upperTailedPValue(m, l, n, k);
 		} else {
-			p = hyperTest_.lowerTailedPValue(m_, l, n_, k);
+			p = hyperTest.lowerTailedPValue(m, l, n, k);
 		}
 	} else {
+		FishersExactTest<uint64_t, big_float> fisherTest(table);
 		if(enriched) {
-			p = fisherTest_.upperTailedPValue(m_, l, n_, k);
+			p = fisherTest.upperTailedPValue(m, l, n, k);
 		} else {
-			p = fisherTest_.lowerTailedPValue(m_, l, n_, k);
+			p = fisherTest.lowerTailedPValue(m, l, n, k);
 		}
 	}
 
@@ -88,8 +123,16 @@ double OverRepresentationAnalysis::computeScore(const Category& category) const
 	// GeneTrail 1
 	// size_t l = category.size();
 
-	size_t k = Category::intersect("null", category, test_set_).size();
-	size_t l = Category::intersect("null", category, reference_set_).size();
+	size_t k = test_bits_.intersectionSize(category);
+	size_t l = reference_bits_.intersectionSize(category);
+
+	double log_p = useHypergeometricTest_
+	                   ? hypergeometric::logProbability(*table_, m_, l, n_, k)
+	                   : hypergeometric::logProbability(*table_, m_ + n_, n_, l + k, k);
+
+	if(log_p > std::log(std::numeric_limits<double>::min())) {
+		return std::exp(log_p);
+	}
 
 	if(useHypergeometricTest_) {
 		return hyperTest_.compute(m_, l, n_, k).convert_to<double>();
@@ -23,10 +23,13 @@
 #include "macros.h"
 
 #include "Category.h"
+#include "EntityBitset.h"
 #include "FishersExactTest.h"
 #include "HypergeometricTest.h"
+#include "LogFactorialTable.h"
 #include "multiprecision.h"
 
+#include <memory>
 #include <utility>
 #include <tuple>
 
@@ -65,6 +68,23 @@ namespace GeneTrail {
 			 */
 			double computePValue(const Category& category) const;
 
+			/**
+			 * Computes the one-sided p-value from the counts alone.
+			 *
+			 * @param table A table containing at least the factorials up to (m + n)!.
+			 * @param m Number of genes in the reference set
+			 * @param l Number of genes of the category in the reference set
+			 * @param n Number of genes in the test set
+			 * @param k Number of genes of the category in the test set
+			 * @param useHypergeometricTest Whether the test set is a subset of
+			 *        the reference set. Otherwise, Fisher's exact test is used.
+			 *
+			 * @return P-value
+			 */
+			static double computePValue(const std::shared_ptr<const LogFactorialTable>& table,
+			                            size_t m, size_t l, size_t n, size_t k,
+			                            bool useHypergeometricTest);
+
 			double computeScore(const Category& category) const;
 
 			double numberOfHits(const Category& category) const;
@@ -80,8 +100,16 @@ namespace GeneTrail {
 			//Size of test set
 			size_t n_;
 
+			// Dense copies of both sets for counting the hits
+			// of a category without allocations.
+			EntityBitset reference_bits_;
+			EntityBitset test_bits_;
+
 			bool useHypergeometricTest_;
 
+			// Shared by all tests, covers populations of m_ + n_ genes.
+			std::shared_ptr<const LogFactorialTable> table_;
+
 			FishersExactTest<uint64_t, big_float> fisherTest_;
 			HypergeometricTest<uint64_t, big_float> hyperTest_;
 
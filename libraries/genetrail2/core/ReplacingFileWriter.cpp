@@ -0,0 +1,69 @@
+/*
+ * GeneTrail2 - An efficient library for interpreting genetic data
+ * Copyright (C) 2016 Daniel Stöckel <dstoeckel@bioinf.uni-sb.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Lesser GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Lesser GNU General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "ReplacingFileWriter.h"
+
+#include "Exception.h"
+
+#include <boost/filesystem.hpp>
+
+#include <cstdio>
+
+namespace GeneTrail
+{
+	ReplacingFileWriter::ReplacingFileWriter(const std::string& path)
+	    : path_(path), committed_(false)
+	{
+		// The random suffix keeps concurrent writers of the same target
+		// apart. Staying in the same directory keeps rename() atomic.
+		tmpPath_ =
+		    boost::filesystem::unique_path(path + ".%%%%-%%%%-%%%%.tmp")
+		        .string();
+
+		strm_.open(tmpPath_, std::ios::binary | std::ios::trunc);
+
+		if(!strm_) {
+			throw IOError("Could not open '" + tmpPath_ + "' for writing.");
+		}
+	}
+
+	ReplacingFileWriter::~ReplacingFileWriter()
+	{
+		if(!committed_) {
+			strm_.close();
+			std::remove(tmpPath_.c_str());
+		}
+	}
+
+	void ReplacingFileWriter::commit()
+	{
+		strm_.close();
+
+		if(!strm_) {
+			throw IOError("Could not write '" + tmpPath_ + "'.");
+		}
+
+		if(std::rename(tmpPath_.c_str(), path_.c_str()) != 0) {
+			throw IOError("Could not replace '" + path_ + "' by '" +
+			              tmpPath_ + "'.");
+		}
+
+		committed_ = true;
+	}
+}
@@ -0,0 +1,72 @@
+/*
+ * GeneTrail2 - An efficient library for interpreting genetic data
+ * Copyright (C) 2016 Daniel Stöckel <dstoeckel@bioinf.uni-sb.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Lesser GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Lesser GNU General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef GT2_CORE_REPLACING_FILE_WRITER_H
+#define GT2_CORE_REPLACING_FILE_WRITER_H
+
+#include "macros.h"
+
+#include <fstream>
+#include <string>
+
+namespace GeneTrail
+{
+	/**
+	 * Writes a binary file that replaces the file at a given path in a
+	 * single step.
+	 *
+	 * The data is written to a temporary file in the directory of the
+	 * target, which is renamed over the target by commit(). Processes
+	 * reading or mapping the target concurrently thus either see the old
+	 * or the new file, but never a partially written one. If commit() is
+	 * not called, the temporary file is removed again.
+	 */
+	class GT2_EXPORT ReplacingFileWriter
+	{
+		public:
+		/**
+		 * Creates the temporary file for the given target.
+		 *
+		 * @throws IOError if the temporary file cannot be created.
+		 */
+		explicit ReplacingFileWriter(const std::string& path);
+		~ReplacingFileWriter();
+
+		ReplacingFileWriter(const ReplacingFileWriter&) = delete;
+		ReplacingFileWriter& operator=(const ReplacingFileWriter&) = delete;
+
+		/// The stream writing to the temporary file.
+		std::ofstream& stream() { return strm_; }
+
+		/**
+		 * Closes the temporary file and renames it to the target.
+		 *
+		 * @throws IOError if writing the file or renaming it failed.
+		 */
+		void commit();
+
+		private:
+		std::string path_;
+		std::string tmpPath_;
+		std::ofstream strm_;
+		bool committed_;
+	};
+}
+
+#endif // GT2_CORE_REPLACING_FILE_WRITER_H
@@ -0,0 +1,78 @@
+/*
+ * GeneTrail2 - An efficient library for interpreting genetic data
+ * Copyright (C) 2016 Daniel Stöckel <dstoeckel@bioinf.uni-sb.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Lesser GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Lesser GNU General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef GT2_CORE_ROW_MEDIANS_H
+#define GT2_CORE_ROW_MEDIANS_H
+
+#include "macros.h"
+
+#include "Statistic.h"
+
+#include <Eigen/Core>
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace GeneTrail
+{
+	/**
+	 * Computes the medians of all rows of a matrix whose columns can be
+	 * accessed as contiguous Eigen vectors via col(j), e.g. a DenseMatrix
+	 * or a DenseColumnSubset.
+	 *
+	 * The rows are processed in blocks. Every block is gathered column by
+	 * column into a buffer in which the values of each row are adjacent,
+	 * so that all reads from the matrix are sequential. The medians are
+	 * then selected in place in the buffer, which is allocated only once.
+	 *
+	 * @param m The matrix.
+	 * @return The median of every row.
+	 */
+	template <typename Matrix> Eigen::ArrayXd rowMedians(const Matrix& m)
+	{
+		const size_t block_size = 256;
+
+		const size_t rows = m.rows();
+		const size_t n = m.cols();
+
+		Eigen::ArrayXd result(rows);
+		std::vector<double> buffer(std::min(rows, block_size) * n);
+
+		for(size_t begin = 0; begin < rows; begin += block_size) {
+			const size_t size = std::min(block_size, rows - begin);
+
+			for(size_t j = 0; j < n; ++j) {
+				const double* col = m.col(j).data() + begin;
+				for(size_t i = 0; i < size; ++i) {
+					buffer[i * n + j] = col[i];
+				}
+			}
+
+			for(size_t i = 0; i < size; ++i) {
+				auto row = buffer.begin() + i * n;
+				result(begin + i) = statistic::median_in_place(row, row + n);
+			}
+		}
+
+		return result;
+	}
+}
+
+#endif // GT2_CORE_ROW_MEDIANS_H
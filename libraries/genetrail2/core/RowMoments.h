@@ -0,0 +1,105 @@
+/*
+ * GeneTrail2 - An efficient library for interpreting genetic data
+ * Copyright (C) 2016 Daniel Stöckel <dstoeckel@bioinf.uni-sb.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Lesser GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Lesser GNU General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef GT2_CORE_ROW_MOMENTS_H
+#define GT2_CORE_ROW_MOMENTS_H
+
+#include "macros.h"
+
+#include <Eigen/Core>
+
+#include <cstddef>
+
+namespace GeneTrail
+{
+	/**
+	 * The mean and the sample variance of every row of a matrix.
+	 */
+	struct RowMoments
+	{
+		Eigen::ArrayXd mean;
+		Eigen::ArrayXd var;
+		/// The number of columns the moments were computed from.
+		size_t n;
+	};
+
+	/**
+	 * Computes the moments of all rows from the columns col(0), ...,
+	 * col(n - 1) in a single pass.
+	 *
+	 * The update is the same as in statistic::mean_var_size, but it is
+	 * applied to whole columns. As the columns of a dense matrix are
+	 * contiguous in memory, every update is a vectorised Eigen expression
+	 * instead of a strided walk along each row.
+	 *
+	 * @param rows The number of rows.
+	 * @param n    The number of columns.
+	 * @param col  A function returning an Eigen expression for the j-th
+	 *             column.
+	 */
+	template <typename ColumnFunction>
+	RowMoments rowMoments(size_t rows, size_t n, ColumnFunction col)
+	{
+		RowMoments result;
+		result.n = n;
+		result.mean = Eigen::ArrayXd::Zero(rows);
+		result.var = Eigen::ArrayXd::Zero(rows);
+
+		Eigen::ArrayXd x(rows);
+		Eigen::ArrayXd delta(rows);
+		for(size_t j = 0; j < n; ++j) {
+			x = col(j);
+			delta = x - result.mean;
+			result.mean += delta * (1.0 / static_cast<double>(j + 1));
+			result.var += delta * (x - result.mean);
+		}
+
+		if(n <= 1) {
+			result.var.setZero();
+		} else {
+			result.var /= static_cast<double>(n - 1);
+		}
+
+		return result;
+	}
+
+	/**
+	 * Computes the moments of the rows of the given matrix. The matrix
+	 * must provide access to its columns as Eigen expressions.
+	 */
+	template <typename Matrix> RowMoments rowMoments(const Matrix& m)
+	{
+		return rowMoments(m.rows(), m.cols(),
+		                  [&m](size_t j) { return m.col(j).array(); });
+	}
+
+	/**
+	 * Computes the moments of the rows of the difference a - b of two
+	 * matrices with the same dimensions.
+	 */
+	template <typename Matrix>
+	RowMoments rowDifferenceMoments(const Matrix& a, const Matrix& b)
+	{
+		return rowMoments(a.rows(), a.cols(), [&a, &b](size_t j) {
+			return a.col(j).array() - b.col(j).array();
+		});
+	}
+}
+
+#endif // GT2_CORE_ROW_MOMENTS_H
@@ -22,24 +22,27 @@
 #include "GeneSet.h"
 
 #include <algorithm>
+#include <cassert>
+#include <numeric>
 
 namespace GeneTrail
 {
-	Scores::IndexProxy::IndexProxy(const std::vector<Score>* data) : data_(data)
+	Scores::IndexProxy::IndexProxy(const std::vector<index_type>* data)
+	    : data_(data)
 	{
 	}
 
-	Scores::ConstScoresProxy::ConstScoresProxy(const std::vector<Score>* data)
+	Scores::ConstScoresProxy::ConstScoresProxy(const std::vector<double>* data)
 	    : data_(data)
 	{
 	}
 
-	Scores::ScoresProxy::ScoresProxy(std::vector<Score>* data)
+	Scores::ScoresProxy::ScoresProxy(std::vector<double>* data)
 	    : data_(data)
 	{
 	}
 
-	Scores::NamesProxy::NamesProxy(const std::vector<Score>* data,
+	Scores::NamesProxy::NamesProxy(const std::vector<index_type>* data,
 	                               const EntityDatabase* db)
 	    : data_(data), db_(db)
 	{
@@ -70,13 +73,18 @@ namespace GeneTrail
 
 	Scores::Scores(const std::vector<Score>& data,
 	               const std::shared_ptr<EntityDatabase>& db)
-	    : data_(data), isSortedByIndex_(false), db_(db)
+	    : isSortedByIndex_(true), db_(db)
 	{
+		reserve(data.size());
+
+		for(const auto& score : data) {
+			emplace_back(score);
+		}
 	}
 
 	Scores::Scores(std::vector<Score>&& data,
 	               const std::shared_ptr<EntityDatabase>& db)
-	    : data_(std::move(data)), isSortedByIndex_(false), db_(db)
+	    : Scores(static_cast<const std::vector<Score>&>(data), db)
 	{
 	}
 
@@ -84,7 +92,7 @@ namespace GeneTrail
 	               const std::shared_ptr<EntityDatabase>& db)
 	    : isSortedByIndex_(true), db_(db)
 	{
-		data_.reserve(gene_set.size());
+		reserve(gene_set.size());
 
 		// Insert the entries of the gene set. emplace_back
 		// ensures, that isSortedByName_ is updated properly.
@@ -97,7 +105,7 @@ namespace GeneTrail
 	               const std::shared_ptr<EntityDatabase>& db)
 	    : isSortedByIndex_(true), db_(db)
 	{
-		data_.reserve(gene_set.size());
+		reserve(gene_set.size());
 
 		// Insert the entries of the gene set. emplace_back
 		// ensures, that isSortedByName_ is updated properly.
@@ -113,7 +121,13 @@ namespace GeneTrail
 	Scores::Scores(size_t size, const std::shared_ptr<EntityDatabase>& db)
 	    : isSortedByIndex_(true), db_(db)
 	{
-		data_.reserve(size);
+		reserve(size);
+	}
+
+	void Scores::reserve(size_t size)
+	{
+		ids_.reserve(size);
+		values_.reserve(size);
 	}
 
 	Scores Scores::subset(const Category& c) const
@@ -130,11 +144,13 @@ namespace GeneTrail
 		auto n = size();
 		Scores result(std::min(n, c.size()), db_);
 
-		auto scoresIt = begin();
+		auto first = ids_.begin();
+		auto last = ids_.end();
+		auto scoresIt = first;
 		auto categoryIt = c.begin();
 
-		while(scoresIt != end() && categoryIt != c.end()) {
-			auto search_end = end();
+		while(scoresIt != last && categoryIt != c.end()) {
+			auto search_end = last;
 
 			// This is a heuristic that tries to guess the position
 			// of the current category element in the scores vector
@@ -145,15 +161,16 @@ namespace GeneTrail
 			if(*categoryIt < n) {
 				// Look up the score index that can be found at the
 				// current index in the category.
-				auto cat_lookup = begin() + *categoryIt;
-				auto scores_index = cat_lookup->index();
+				auto cat_lookup = first + *categoryIt;
+				auto scores_index = *cat_lookup;
 
 				if(scores_index == *categoryIt) {
 					// If we hit what we were looking for, we
 					// are done and can continue.
 					scoresIt = cat_lookup + 1;
 					++categoryIt;
-					result.emplace_back(*cat_lookup);
+					result.push_back_(*cat_lookup,
+					                  values_[cat_lookup - first]);
 					continue;
 				} else if(scores_index > *categoryIt) {
 					// If the found index is larger than what we were looking
@@ -166,14 +183,11 @@ namespace GeneTrail
 				}
 			}
 
-			// TODO: Temporary can be optimized away using C++14 heterogenous
-			//      lookup.
-			Score dummy(*categoryIt, 0.0);
-			scoresIt = std::lower_bound(scoresIt, search_end, dummy, LessIndex());
+			scoresIt = std::lower_bound(scoresIt, search_end, *categoryIt);
 
 			// Check that we found the index we searched for
 			if(scoresIt != search_end) {
-				result.emplace_back(*scoresIt);
+				result.push_back_(*scoresIt, values_[scoresIt - first]);
 				++scoresIt;
 			}
 			++categoryIt;
@@ -188,9 +202,9 @@ namespace GeneTrail
 
 		Scores result(std::min(size(), c.size()), db_);
 
-		for(const auto& entry : *this) {
-			if(c.contains(entry.index())) {
-				result.emplace_back(entry);
+		for(size_t i = 0; i < size(); ++i) {
+			if(c.contains(ids_[i])) {
+				result.push_back_(ids_[i], values_[i]);
 			}
 		}
 
@@ -203,7 +217,7 @@ namespace GeneTrail
 		result.reserve(std::min(size(), c.size()));
 
 		for(size_t i = 0; i < size(); ++i) {
-			if(c.contains(data_[i].index())) {
+			if(c.contains(ids_[i])) {
 				result.emplace_back(i);
 			}
 		}
@@ -211,6 +225,23 @@ namespace GeneTrail
 		return result;
 	}
 
+	template <typename Compare> void Scores::sortBy_(Compare comp)
+	{
+		std::vector<size_t> permutation(size());
+		std::iota(permutation.begin(), permutation.end(), 0);
+		std::sort(permutation.begin(), permutation.end(), comp);
+
+		std::vector<index_type> ids(size());
+		std::vector<double> values(size());
+		for(size_t i = 0; i < size(); ++i) {
+			ids[i] = ids_[permutation[i]];
+			values[i] = values_[permutation[i]];
+		}
+
+		ids_.swap(ids);
+		values_.swap(values);
+	}
+
 	void Scores::sortByIndex()
 	{
 		// Nothing to do here
@@ -220,16 +251,15 @@ namespace GeneTrail
 
 		isSortedByIndex_ = true;
 
-		std::sort(data_.begin(), data_.end(), LessIndex());
+		sortBy_([this](size_t a, size_t b) { return ids_[a] < ids_[b]; });
 	}
 
 	void Scores::sortByName()
 	{
 		isSortedByIndex_ = size() <= 1;
 
-		std::sort(data_.begin(), data_.end(),
-		          [this](const Score& a, const Score& b) {
-			return a.name(*db_) < b.name(*db_);
+		sortBy_([this](size_t a, size_t b) {
+			return (*db_)(ids_[a]) < (*db_)(ids_[b]);
 		});
 	}
 
@@ -240,10 +270,20 @@ namespace GeneTrail
 
 		switch(order) {
 			case Order::Increasing:
-				std::sort(data_.begin(), data_.end(), LessScore());
+				sortBy_([this](size_t a, size_t b) {
+					if(values_[a] == values_[b]) {
+						return ids_[a] < ids_[b];
+					}
+					return values_[a] < values_[b];
+				});
 				break;
 			case Order::Decreasing:
-				std::sort(data_.begin(), data_.end(), GreaterScore());
+				sortBy_([this](size_t a, size_t b) {
+					if(values_[a] == values_[b]) {
+						return ids_[a] > ids_[b];
+					}
+					return values_[a] > values_[b];
+				});
 				break;
 		}
 	}
@@ -257,15 +297,12 @@ namespace GeneTrail
 
 	bool Scores::contains(const Score& score) const
 	{
+		const auto index = score.index();
+
 		if(isSortedByIndex_) {
-			return std::binary_search(data_.begin(), data_.end(), score, LessIndex());
+			return std::binary_search(ids_.begin(), ids_.end(), index);
 		} else {
-			auto pred = [&score](const Score& a) {
-				return a.index() == score.index();
-			};
-
-			return std::find_if(data_.begin(), data_.end(), pred) !=
-		           data_.end();
+			return std::find(ids_.begin(), ids_.end(), index) != ids_.end();
 		}
 	}
 }
@@ -23,8 +23,11 @@
 #include "macros.h"
 #include "EntityDatabase.h"
 
+#include <boost/iterator/iterator_facade.hpp>
 #include <boost/iterator/transform_iterator.hpp>
 
+#include <cstddef>
+#include <iterator>
 #include <memory>
 #include <string>
 #include <vector>
@@ -45,47 +48,82 @@ namespace GeneTrail
 		Score(EntityDatabase& db, const std::string& n, double s) : entity_(db(n)), score_(s) {}
 		Score(size_t i, double s) : entity_(i), score_(s) {}
 
-		const std::string& name(const EntityDatabase& db) const { return db(entity_); }
+		EntityDatabase::NameRef name(const EntityDatabase& db) const { return db(entity_); }
 		size_t index() const { return entity_; }
 
-		double& score() { return score_; }
-		double score() const { return score_; }
+		// The mutable accessor is restricted to lvalues, as writing to a
+		// temporary Score returned by Scores would be silently lost.
+		double& score() & { return score_; }
+		double score() const& { return score_; }
 
 		private:
 		size_t entity_;
 		double score_;
 	};
 
+	/**
+	 * A list of scores for the entities of an EntityDatabase.
+	 *
+	 * The identifiers and the values are stored in two separate contiguous
+	 * arrays. Kernels can thus access the values and the identifiers
+	 * directly via scores().data() and indices().data(). Iterating over
+	 * the Scores object itself yields Score objects by value.
+	 */
 	class GT2_EXPORT Scores
 	{
 		public:
-		using iterator = std::vector<Score>::iterator;
-		using const_iterator = std::vector<Score>::const_iterator;
+		/// The type used for storing the identifiers of the entities.
+		using index_type = EntityDatabase::index_type;
 
-		class IndexProxy
+		class const_iterator
+		    : public boost::iterator_facade<const_iterator, Score,
+		                                    std::random_access_iterator_tag,
+		                                    Score>
 		{
+			public:
+			const_iterator() : scores_(nullptr), i_(0) {}
+			const_iterator(const Scores* scores, size_t i)
+			    : scores_(scores), i_(i)
+			{
+			}
+
 			private:
-			struct ExtractIndex
+			friend class boost::iterator_core_access;
+
+			Score dereference() const { return (*scores_)[i_]; }
+
+			bool equal(const const_iterator& o) const { return i_ == o.i_; }
+
+			void increment() { ++i_; }
+			void decrement() { --i_; }
+			void advance(std::ptrdiff_t n) { i_ += n; }
+
+			std::ptrdiff_t distance_to(const const_iterator& o) const
 			{
-				size_t operator()(const Score& s) const
-				{
-					return s.index();
-				}
-			};
+				return static_cast<std::ptrdiff_t>(o.i_) -
+				       static_cast<std::ptrdiff_t>(i_);
+			}
 
-			const std::vector<Score>* data_;
+			const Scores* scores_;
+			size_t i_;
+		};
+
+		using iterator = const_iterator;
+
+		class IndexProxy
+		{
+			private:
+			const std::vector<index_type>* data_;
 
 			public:
-			using const_iterator = boost::transform_iterator<ExtractIndex, Scores::const_iterator>;
-			IndexProxy(const std::vector<Score>* data);
+			using const_iterator = const index_type*;
+			IndexProxy(const std::vector<index_type>* data);
 
-			const_iterator begin() const {
-				return boost::make_transform_iterator(data_->begin(), ExtractIndex());
-			}
+			const_iterator begin() const { return data_->data(); }
+			const_iterator end() const { return data_->data() + data_->size(); }
 
-			const_iterator end() const {
-				return boost::make_transform_iterator(data_->end(), ExtractIndex());
-			}
+			const index_type* data() const { return data_->data(); }
+			size_t size() const { return data_->size(); }
 		};
 
 		class NamesProxy
@@ -94,88 +132,66 @@ namespace GeneTrail
 			struct ExtractName
 			{
 				ExtractName(const EntityDatabase* db) : db_(db) {}
-				const std::string& operator()(const Score& s) const
+				EntityDatabase::NameRef operator()(index_type i) const
 				{
-					return s.name(*db_);
+					return (*db_)(i);
 				};
 			private:
 			const EntityDatabase* db_;
 			};
-			const std::vector<Score>* data_;
+			const std::vector<index_type>* data_;
 			const EntityDatabase* db_;
 
 			public:
 			using const_iterator =
-			    boost::transform_iterator<ExtractName, Scores::const_iterator>;
+			    boost::transform_iterator<ExtractName, const index_type*>;
 
-			NamesProxy(const std::vector<Score>* data, const EntityDatabase* db_);
+			NamesProxy(const std::vector<index_type>* data, const EntityDatabase* db_);
 
 			const_iterator begin() const
 			{
-				return boost::make_transform_iterator(data_->begin(),
+				return boost::make_transform_iterator(data_->data(),
 				                                      ExtractName(db_));
 			}
 			const_iterator end() const
 			{
-				return boost::make_transform_iterator(data_->end(),
-				                                      ExtractName(db_));
+				return boost::make_transform_iterator(
+				    data_->data() + data_->size(), ExtractName(db_));
 			}
 		};
 
 		class ConstScoresProxy
 		{
 			private:
-			struct ExtractScore
-			{
-				double operator()(const Score& s) const { return s.score(); }
-			};
-			const std::vector<Score>* data_;
+			const std::vector<double>* data_;
 
 			public:
-			using const_iterator =
-			    boost::transform_iterator<ExtractScore, Scores::const_iterator>;
+			using const_iterator = const double*;
 
-			ConstScoresProxy(const std::vector<Score>* data);
+			ConstScoresProxy(const std::vector<double>* data);
 
-			const_iterator begin() const
-			{
-				return boost::make_transform_iterator(data_->begin(),
-				                                      ExtractScore());
-			}
+			const_iterator begin() const { return data_->data(); }
+			const_iterator end() const { return data_->data() + data_->size(); }
 
-			const_iterator end() const
-			{
-				return boost::make_transform_iterator(data_->end(),
-				                                      ExtractScore());
-			}
+			const double* data() const { return data_->data(); }
+			size_t size() const { return data_->size(); }
 		};
 
 		class ScoresProxy
 		{
 			private:
-			struct ExtractScore
-			{
-				double& operator()(Score& s) const { return s.score(); }
-			};
-			std::vector<Score>* data_;
+			std::vector<double>* data_;
 
 			public:
-			using iterator =
-			    boost::transform_iterator<ExtractScore, Scores::iterator>;
+			using iterator = double*;
 
-			ScoresProxy(std::vector<Score>* data);
+			ScoresProxy(std::vector<double>* data);
 
-			iterator begin()
-			{
-				return boost::make_transform_iterator(data_->begin(),
-				                                      ExtractScore());
-			}
+			iterator begin() { return data_->data(); }
+			iterator end() { return data_->data() + data_->size(); }
 
-			iterator end()
-			{
-				return boost::make_transform_iterator(data_->end(),
-				                                      ExtractScore());
-			}
+			double* data() { return data_->data(); }
+			size_t size() const { return data_->size(); }
 		};
 
 		struct LessScore {
@@ -210,53 +226,50 @@ namespace GeneTrail
 
 		template <typename... Ts> void emplace_back(const char* str, Ts&&... ts)
 		{
-			data_.emplace_back(db_->index(str), std::forward<Ts>(ts)...);
-			updateIsSorted_();
+			push_back_(db_->index(str), std::forward<Ts>(ts)...);
 		}
 
 		template <typename... Ts> void emplace_back(const std::string& str, Ts&&... ts)
 		{
-			data_.emplace_back(db_->index(str), std::forward<Ts>(ts)...);
-			updateIsSorted_();
+			push_back_(db_->index(str), std::forward<Ts>(ts)...);
 		}
 
 		template <typename... Ts> void emplace_back(std::string&& str, Ts&&... ts)
 		{
-			data_.emplace_back(db_->index(str), std::forward<Ts>(ts)...);
-			updateIsSorted_();
+			push_back_(db_->index(str), std::forward<Ts>(ts)...);
 		}
 
 		template <typename... Ts> void emplace_back(Ts&&... ts)
 		{
-			data_.emplace_back(std::forward<Ts>(ts)...);
-			updateIsSorted_();
+			const Score score(std::forward<Ts>(ts)...);
+			push_back_(score.index(), score.score());
 		}
 
-		iterator begin() { return data_.begin(); }
-		iterator end() { return data_.end(); }
-
-		const_iterator begin() const { return data_.begin(); }
-		const_iterator end() const { return data_.end(); }
+		const_iterator begin() const { return const_iterator(this, 0); }
+		const_iterator end() const { return const_iterator(this, size()); }
 
-		IndexProxy indices() const { return IndexProxy(&data_); };
-		NamesProxy names() const { return NamesProxy(&data_, db_.get()); };
-		ConstScoresProxy scores() const { return ConstScoresProxy(&data_); };
-		ScoresProxy scores() { return ScoresProxy(&data_); };
+		IndexProxy indices() const { return IndexProxy(&ids_); };
+		NamesProxy names() const { return NamesProxy(&ids_, db_.get()); };
+		ConstScoresProxy scores() const { return ConstScoresProxy(&values_); };
+		ScoresProxy scores() { return ScoresProxy(&values_); };
 
 		const std::shared_ptr<EntityDatabase>& db() const { return db_; }
 
-		size_t size() const { return data_.size(); }
+		size_t size() const { return values_.size(); }
+
+		void reserve(size_t size);
 
 		Scores subset(const Category& c) const;
 		std::vector<size_t> subsetIndices(const Category& c) const;
 
-		const Score& set(size_t i, const Score& s) {
+		Score set(size_t i, const Score& s) {
 			isSortedByIndex_ = false;
-			data_[i] = s;
-			return data_[i];
+			ids_[i] = static_cast<index_type>(s.index());
+			values_[i] = s.score();
+			return s;
 		}
 
-		const Score& operator[](size_t i) const { return data_[i]; }
+		Score operator[](size_t i) const { return Score(ids_[i], values_[i]); }
 
 		void sortByName();
 		void sortByIndex();
@@ -270,11 +283,25 @@ namespace GeneTrail
 		Scores subsetMerge_(const Category& c) const;
 		Scores subsetFind_(const Category& c) const;
 
+		void push_back_(size_t index, double score)
+		{
+			ids_.push_back(static_cast<index_type>(index));
+			values_.push_back(score);
+			updateIsSorted_();
+		}
+
+		/**
+		 * Sorts both arrays by the permutation that sorts the positions
+		 * 0, ..., size() - 1 with respect to comp.
+		 */
+		template <typename Compare> void sortBy_(Compare comp);
+
 		void updateIsSorted_() {
-			isSortedByIndex_ = size() <= 1 || (isSortedByIndex_ && data_[size() - 1].index() >= data_[size() - 2].index());
+			isSortedByIndex_ = size() <= 1 || (isSortedByIndex_ && ids_[size() - 1] >= ids_[size() - 2]);
 		}
 
-		std::vector<Score> data_;
+		std::vector<index_type> ids_;
+		std::vector<double> values_;
 		bool isSortedByIndex_;
 		std::shared_ptr<EntityDatabase> db_;
 	};
@@ -20,14 +20,17 @@
 #ifndef GT2_CORE_SHRINKAGE_T_TEST_H
 #define GT2_CORE_SHRINKAGE_T_TEST_H
 
+#include <algorithm>
 #include <vector>
 #include <cmath>
 #include <tuple>
+#include <type_traits>
 #include <utility>
 
 #include "macros.h"
 
 #include "Statistic.h"
+#include "Workers.h"
 
 #include <boost/iterator/filter_iterator.hpp>
 
@@ -43,6 +46,63 @@ namespace GeneTrail {
 		size_t size;
 	};
 
+	/**
+	 * Accumulates the central moments of a sample up to the fourth order
+	 * in a single pass.
+	 *
+	 * The update is the numerically stable one-pass algorithm by Pébay
+	 * (2008), which generalises Welford's algorithm for the variance. It
+	 * yields everything needed for the shrinkage estimator without
+	 * storing the sample.
+	 */
+	template <typename value_type>
+	struct ShrinkageMoments
+	{
+		size_t n = 0;
+		value_type mean = 0.0;
+		value_type M2 = 0.0;
+		value_type M3 = 0.0;
+		value_type M4 = 0.0;
+
+		void add(value_type x)
+		{
+			const value_type n1 = static_cast<value_type>(n);
+			++n;
+			const value_type nn = static_cast<value_type>(n);
+
+			const value_type delta = x - mean;
+			const value_type delta_n = delta / nn;
+			const value_type delta_n2 = delta_n * delta_n;
+			const value_type term = delta * delta_n * n1;
+
+			mean += delta_n;
+			M4 += term * delta_n2 * (nn * nn - 3 * nn + 3) +
+			      6 * delta_n2 * M2 - 4 * delta_n * M3;
+			M3 += term * delta_n * (nn - 2) - 3 * delta_n * M2;
+			M2 += term;
+		}
+
+		/**
+		 * The moments of the sample in the form needed by the shrinkage
+		 * t-test.
+		 *
+		 * var is the unbiased variance and Var the estimated variance of
+		 * var. With w_i = (x_i - mean)^2 and w = M2 / n,
+		 * sum_i (w_i - w)^2 = M4 - M2 * w.
+		 */
+		Gene<value_type> gene() const
+		{
+			const value_type size = static_cast<value_type>(n);
+			const value_type size_1 = size - 1;
+
+			const value_type wk = M2 / size;
+			const value_type Var = std::max(M4 - M2 * wk, value_type(0)) *
+			                       size / (size_1 * size_1 * size_1);
+
+			return Gene<value_type>{mean, M2 / size_1, Var, 0.0, n};
+		}
+	};
+
 	/**
 	 * Shrinkage T-Test
 	 *
@@ -60,9 +120,8 @@ namespace GeneTrail {
 
 		public:
 		/**
-		 * Computes the different variances for a single gene.
-		 *
-		 * @todo Use a compensated algorithm for computing the variance.
+		 * Computes the different variances for a single gene in a single
+		 * pass over the range.
 		 *
 		 * @param begin InputIterator
 		 * @param end InputIterator
@@ -72,35 +131,12 @@ namespace GeneTrail {
 		Gene<value_type> computeVariances(InputIterator begin,
 		                                  InputIterator end)
 		{
-			const size_t size = std::distance(begin, end);
-			wik_.resize(size);
-
-			value_type mean = 0.0;
-			for (size_t i = 0; i < size; ++i, ++begin) {
-				mean += wik_[i] = *begin;
+			ShrinkageMoments<value_type> moments;
+			for(; begin != end; ++begin) {
+				moments.add(*begin);
 			}
-			mean /= size;
 
-			value_type sum_wik = 0.0;
-			for(auto& item : wik_) {
-				item -= mean;
-				item *= item;
-				sum_wik += item;
-			}
-
-			const auto wk = sum_wik / size;
-
-			//TODO: Use compensated variance algorithm here
-			value_type Var = (value_type) 0;
-			for (const auto& item : wik_) {
-				auto diff = item - wk;
-				Var += diff*diff;
-			}
-
-			const size_t size_1 = size - 1;
-			Var *= ((value_type)size) / (size_1 * size_1 * size_1);
-
-			return Gene<value_type>{mean, sum_wik / size_1, Var, 0.0, size};
+			return moments.gene();
 		}
 
 		/**
@@ -112,20 +148,15 @@ namespace GeneTrail {
 		 */
 		template <typename InputIterator>
 		std::tuple<std::vector<Gene<value_type>>,value_type> computeAllVariances(InputIterator begin, InputIterator end){
-			const auto n = std::distance(begin, end);
-
 			std::vector<Gene<value_type>> variances;
-			std::vector<value_type> vars;
-
-			variances.reserve(n);
-			vars.reserve(n);
+			variances.reserve(std::distance(begin, end));
 
 			for (auto iter = begin; iter != end; ++iter) {
 				variances.emplace_back(computeVariances(iter->begin(), iter->end()));
-				vars.emplace_back(variances.back().var);
 			}
 
-			return std::make_pair(variances, statistic::median<value_type>(vars.begin(), vars.end()));
+			const auto var_median = medianVariance_(variances);
+			return std::make_pair(std::move(variances), var_median);
 		}
 
 		/**
@@ -137,13 +168,8 @@ namespace GeneTrail {
 		 */
 		template <typename InputIterator>
 		std::tuple<std::vector<Gene<value_type>>,value_type> computeAllVariancesRemoveNaN(InputIterator begin, InputIterator end) {
-			const auto n = std::distance(begin, end);
-
 			std::vector<Gene<value_type>> variances;
-			std::vector<value_type> vars;
-
-			variances.reserve(n);
-			vars.reserve(n);
+			variances.reserve(std::distance(begin, end));
 
 			auto is_not_nan = [](value_type x) { return !std::isnan(x); };
 			for (auto iter = begin; iter != end; ++iter) {
@@ -151,10 +177,40 @@ namespace GeneTrail {
 				auto fit_end   = boost::make_filter_iterator(is_not_nan, iter->end(), iter->end());
 
 				variances.emplace_back(computeVariances(fit_begin, fit_end));
-				vars.emplace_back(variances.back().var);
 			}
 
-			return std::make_pair(variances, statistic::median<value_type>(vars.begin(), vars.end()));
+			const auto var_median = medianVariance_(variances);
+			return std::make_pair(std::move(variances), var_median);
+		}
+
+		/**
+		 * Computes the variances of all rows of a matrix whose columns can
+		 * be accessed as contiguous Eigen vectors via col(j).
+		 *
+		 * The rows are processed in blocks. Within a block the matrix is
+		 * traversed column by column, so that all reads are sequential,
+		 * and the moments of the rows are accumulated in a single pass.
+		 * The blocks are distributed over numThreads threads.
+		 *
+		 * @param m The matrix.
+		 * @param numThreads The number of threads to use.
+		 * @return Vector of genes and the median of their variances.
+		 */
+		template <typename Matrix>
+		std::tuple<std::vector<Gene<value_type>>, value_type>
+		computeRowVariances(const Matrix& m, size_t numThreads = 1)
+		{
+			return computeRowVariances_<false>(m, numThreads);
+		}
+
+		/**
+		 * Same as computeRowVariances, but skips NaN values.
+		 */
+		template <typename Matrix>
+		std::tuple<std::vector<Gene<value_type>>, value_type>
+		computeRowVariancesRemoveNaN(const Matrix& m, size_t numThreads = 1)
+		{
+			return computeRowVariances_<true>(m, numThreads);
 		}
 
 		/**
@@ -167,9 +223,10 @@ namespace GeneTrail {
 		value_type estimatePoolingFactor(const std::vector<Gene<value_type>>& genes, value_type var_median){
 			value_type sum_Var = (value_type) 0;
 			value_type sum = (value_type) 0;
-			for(Gene<value_type> g : genes){
+			for(const Gene<value_type>& g : genes){
 				sum_Var += g.Var;
-				sum += std::pow(g.var - var_median, 2);
+				const value_type diff = g.var - var_median;
+				sum += diff * diff;
 			}
 			return std::min((value_type)1, sum_Var / sum);
 		}
@@ -190,7 +247,135 @@ namespace GeneTrail {
 		}
 
 		private:
-			std::vector<value_type> wik_;
+			/// The number of rows that are processed together.
+			constexpr static size_t BLOCK_SIZE = 256;
+
+			template <bool RemoveNaN, typename Matrix>
+			std::tuple<std::vector<Gene<value_type>>, value_type>
+			computeRowVariances_(const Matrix& m, size_t numThreads)
+			{
+				const size_t rows = m.rows();
+				const size_t num_blocks = (rows + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+				std::vector<Gene<value_type>> variances(rows);
+
+				numThreads = std::max<size_t>(
+				    1, std::min<size_t>(numThreads, num_blocks));
+				internal::runWorkers(numThreads, [&](size_t t) {
+					for(size_t b = t; b < num_blocks; b += numThreads) {
+						const size_t begin = b * BLOCK_SIZE;
+						const size_t end = std::min(rows, begin + BLOCK_SIZE);
+						computeBlock_<RemoveNaN>(m, begin, end,
+						                         variances.data() + begin);
+					}
+				});
+
+				const auto var_median = medianVariance_(variances);
+				return std::make_pair(std::move(variances), var_median);
+			}
+
+			/**
+			 * Without NaN values, all rows of a block have seen the same
+			 * number of values after each column. The coefficients of the
+			 * update are thus shared by the whole column and the loop over
+			 * the rows is vectorised by the compiler.
+			 */
+			template <bool RemoveNaN, typename Matrix>
+			static typename std::enable_if<!RemoveNaN>::type
+			computeBlock_(const Matrix& m, size_t begin, size_t end,
+			              Gene<value_type>* out)
+			{
+				const size_t size = end - begin;
+
+				value_type mean[BLOCK_SIZE] = {};
+				value_type M2[BLOCK_SIZE] = {};
+				value_type M3[BLOCK_SIZE] = {};
+				value_type M4[BLOCK_SIZE] = {};
+
+				const size_t n = m.cols();
+				for(size_t j = 0; j < n; ++j) {
+					const value_type* col = m.col(j).data() + begin;
+
+					const value_type n1 = static_cast<value_type>(j);
+					const value_type nn = n1 + 1;
+					const value_type inv = 1 / nn;
+					const value_type c3 = nn - 2;
+					const value_type c4 = nn * nn - 3 * nn + 3;
+
+					for(size_t i = 0; i < size; ++i) {
+						const value_type delta = col[i] - mean[i];
+						const value_type delta_n = delta * inv;
+						const value_type delta_n2 = delta_n * delta_n;
+						const value_type term = delta * delta_n * n1;
+
+						mean[i] += delta_n;
+						M4[i] += term * delta_n2 * c4 + 6 * delta_n2 * M2[i] -
+						         4 * delta_n * M3[i];
+						M3[i] += term * delta_n * c3 - 3 * delta_n * M2[i];
+						M2[i] += term;
+					}
+				}
+
+				for(size_t i = 0; i < size; ++i) {
+					ShrinkageMoments<value_type> moments;
+					moments.n = n;
+					moments.mean = mean[i];
+					moments.M2 = M2[i];
+					moments.M3 = M3[i];
+					moments.M4 = M4[i];
+					out[i] = moments.gene();
+				}
+			}
+
+			template <bool RemoveNaN, typename Matrix>
+			static typename std::enable_if<RemoveNaN>::type
+			computeBlock_(const Matrix& m, size_t begin, size_t end,
+			              Gene<value_type>* out)
+			{
+				ShrinkageMoments<value_type> moments[BLOCK_SIZE];
+
+				for(size_t j = 0; j < static_cast<size_t>(m.cols()); ++j) {
+					const value_type* col = m.col(j).data();
+					for(size_t i = begin; i < end; ++i) {
+						if(!std::isnan(col[i])) {
+							moments[i - begin].add(col[i]);
+						}
+					}
+				}
+
+				for(size_t i = begin; i < end; ++i) {
+					out[i - begin] = moments[i - begin].gene();
+				}
+			}
+
+			/**
+			 * The median of the empirical variances. The variances are
+			 * copied into a buffer that is reused across calls.
+			 */
+			value_type
+			medianVariance_(const std::vector<Gene<value_type>>& genes)
+			{
+				vars_.resize(genes.size());
+				for(size_t i = 0; i < genes.size(); ++i) {
+					vars_[i] = genes[i].var;
+				}
+
+				if(vars_.empty()) {
+					return value_type();
+				}
+
+				const auto mid = vars_.begin() + vars_.size() / 2;
+				std::nth_element(vars_.begin(), mid, vars_.end());
+
+				if(vars_.size() % 2 == 0) {
+					return (*mid + *std::max_element(vars_.begin(), mid)) *
+					       value_type(0.5);
+				}
+
+				return *mid;
+			}
+
+			std::vector<value_type> vars_;
 	};
 }
 
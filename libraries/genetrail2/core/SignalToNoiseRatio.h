@@ -55,14 +55,14 @@ template <typename ValueType> class GT2_EXPORT SignalToNoiseRatio
 	     const InputIterator2& second_begin, const InputIterator2& second_end)
 	{
 		auto mean1 = statistic::mean<value_type>(first_begin, first_end);
-		auto mean2 = statistic::mean<value_type>(first_begin, first_end);
+		auto mean2 = statistic::mean<value_type>(second_begin, second_end);
 		auto sd1 = statistic::sd<value_type>(first_begin, first_end);
 		auto sd2 = statistic::sd<value_type>(second_begin, second_end);
 		score_ = (mean1 - mean2) / (sd1 + sd2);
 		return score_;
 	}
 
-	value_type score() { score_; }
+	value_type score() { return score_; }
 
   protected:
 	value_type tolerance_;
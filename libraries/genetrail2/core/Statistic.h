@@ -22,6 +22,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <iterator>
 #include <numeric>
 #include <tuple>
 #include <vector>
@@ -216,36 +217,73 @@ namespace GeneTrail
 		}
 
 		/**
-		 * This method calculates the median of a given range.
+		 * This method calculates the median of the values in [begin, end)
+		 * without copying them. The range is reordered in the process.
 		 *
-		 * @param begin InputIterator corresponding to the start of the samples.
-		 * @param end   InputIterator corresponding to the end of the samples.
+		 * @param begin RandomAccessIterator corresponding to the start of the samples.
+		 * @param end   RandomAccessIterator corresponding to the end of the samples.
 		 *
 		 * @return Median of the given range
 		 */
-		template <typename value_type, typename InputIterator>
-		value_type median(InputIterator begin, InputIterator end)
+		template <typename RandomAccessIterator>
+		typename std::iterator_traits<RandomAccessIterator>::value_type
+		median_in_place(RandomAccessIterator begin, RandomAccessIterator end)
 		{
-			std::vector<value_type> tmp(begin, end);
+			using value_type =
+			    typename std::iterator_traits<RandomAccessIterator>::value_type;
 
-			const auto dist = std::distance(tmp.begin(), tmp.end());
+			const auto dist = std::distance(begin, end);
 
 			if(dist == 0) {
 				return value_type();
 			}
 
 			const auto dist2 = dist / 2;
-			auto median_position = tmp.begin() + dist2;
-			std::nth_element(tmp.begin(), median_position, tmp.end());
+			auto median_position = begin + dist2;
+			std::nth_element(begin, median_position, end);
 
 			if(2 * dist2 == dist) {
-				auto second = std::max_element(tmp.begin(), median_position);
+				auto second = std::max_element(begin, median_position);
 				return (*median_position + *second) * value_type(0.5);
 			} else {
 				return *median_position;
 			}
 		}
 
+		/**
+		 * This method calculates the median of a given range. The values
+		 * are copied into buffer, which can be reused across calls to
+		 * avoid allocations.
+		 *
+		 * @param begin  InputIterator corresponding to the start of the samples.
+		 * @param end    InputIterator corresponding to the end of the samples.
+		 * @param buffer Scratch space for the copy of the samples.
+		 *
+		 * @return Median of the given range
+		 */
+		template <typename value_type, typename InputIterator>
+		value_type median_buffered(InputIterator begin, InputIterator end,
+		                           std::vector<value_type>& buffer)
+		{
+			buffer.assign(begin, end);
+			return median_in_place(buffer.begin(), buffer.end());
+		}
+
+		/**
+		 * This method calculates the median of a given range.
+		 *
+		 * @param begin InputIterator corresponding to the start of the samples.
+		 * @param end   InputIterator corresponding to the end of the samples.
+		 *
+		 * @return Median of the given range
+		 */
+		template <typename value_type, typename InputIterator>
+		value_type median(InputIterator begin, InputIterator end)
+		{
+			std::vector<value_type> tmp;
+			return median_buffered(begin, end, tmp);
+		}
+
 		/**
 		 * This method calculates the pooled variance of a given range.
 		 *
@@ -397,21 +435,64 @@ namespace GeneTrail
 		}
 
 		/**
+		 * This method computes the ranks of the values in [begin, end) in
+		 * O(n log n). The smallest value receives rank 1 and tied values
+		 * receive the average of their ranks.
+		 *
+		 * @param begin RandomAccessIterator corresponding to the start of the values.
+		 * @param end   RandomAccessIterator corresponding to the end of the values.
+		 * @param out   RandomAccessIterator receiving the rank of the i-th
+		 *              value at position i.
+		 * @param order Scratch space for the sort permutation. Passing the
+		 *              same vector to repeated calls avoids allocations.
 		 */
-		template <typename value_type, typename InputIterator>
-		std::vector<int> ranks(InputIterator begin, InputIterator end)
-		{
-			std::vector<value_type> tmp(begin, end);
-			std::sort(tmp.begin(), tmp.end());
-			std::vector<int> ranks;
-			for(auto it = begin; it != end; ++it) {
-				for(size_t i = 0; i < tmp.size(); ++i) {
-					if(*it == *(tmp.begin() + i)) {
-						ranks.push_back(i);
-					}
+		template <typename RandomAccessIterator1, typename RandomAccessIterator2>
+		void ranks(RandomAccessIterator1 begin, RandomAccessIterator1 end,
+		           RandomAccessIterator2 out, std::vector<size_t>& order)
+		{
+			const size_t n = std::distance(begin, end);
+
+			order.resize(n);
+			std::iota(order.begin(), order.end(), 0);
+			std::sort(order.begin(), order.end(), [begin](size_t a, size_t b) {
+				return begin[a] < begin[b];
+			});
+
+			size_t i = 0;
+			while(i < n) {
+				size_t j = i + 1;
+				while(j < n && begin[order[j]] == begin[order[i]]) {
+					++j;
+				}
+
+				// The elements i, ..., j - 1 are tied and share the average
+				// of the ranks i + 1, ..., j.
+				const double rank = 0.5 * (i + 1 + j);
+				for(size_t k = i; k < j; ++k) {
+					out[order[k]] = rank;
 				}
+
+				i = j;
 			}
-			return ranks;
+		}
+
+		/**
+		 * This method computes the ranks of the values in [begin, end).
+		 * See ranks(begin, end, out, order).
+		 *
+		 * @param begin InputIterator corresponding to the start of the values.
+		 * @param end   InputIterator corresponding to the end of the values.
+		 *
+		 * @return The rank of every value, ties are averaged.
+		 */
+		template <typename value_type, typename InputIterator>
+		std::vector<double> ranks(InputIterator begin, InputIterator end)
+		{
+			std::vector<value_type> values(begin, end);
+			std::vector<double> result(values.size());
+			std::vector<size_t> order;
+			ranks(values.begin(), values.end(), result.begin(), order);
+			return result;
 		}
 
 		/**
@@ -430,11 +511,11 @@ namespace GeneTrail
 		                                InputIterator second_begin,
 		                                InputIterator second_end)
 		{
-			std::vector<int> first_ranks =
+			std::vector<double> first_ranks =
 			    ranks<value_type, InputIterator>(first_begin, first_end);
-			std::vector<int> second_ranks =
+			std::vector<double> second_ranks =
 			    ranks<value_type, InputIterator>(second_begin, second_end);
-			return pearson_correlation<value_type, std::vector<int>::iterator>(
+			return pearson_correlation<value_type, std::vector<double>::iterator>(
 			    first_ranks.begin(), first_ranks.end(), second_ranks.begin(),
 			    second_ranks.end());
 		}
@@ -460,6 +541,29 @@ namespace GeneTrail
 			       std::log(mean<value_type, InputIterator2>(begin2, end2));
 		}
 
+		/**
+		 * Log-Median-Fold-Quotient
+		 * This function calculates log(median(a)) -  log(median(b)).
+		 *
+		 * @param begin1 InputIterator corresponding to the start of the first group.
+		 * @param end1   InputIterator corresponding to the end of the first group.
+		 * @param begin2 InputIterator corresponding to the start of the second group.
+		 * @param end2   InputIterator corresponding to the end of the second group.
+		 * @param buffer Scratch space that is reused for both groups.
+		 *
+		 * @return log(median(a)) -  log(median(b))
+		 */
+		template <typename value_type, typename InputIterator1,
+		          typename InputIterator2>
+		value_type
+		log_median_fold_quotient(InputIterator1 begin1, InputIterator1 end1,
+		                         InputIterator2 begin2, InputIterator2 end2,
+		                         std::vector<value_type>& buffer)
+		{
+			return std::log(median_buffered(begin1, end1, buffer)) -
+			       std::log(median_buffered(begin2, end2, buffer));
+		}
+
 		/**
 		 * Log-Median-Fold-Quotient
 		 * This function calculates log(median(a)) -  log(median(b)).
@@ -477,8 +581,8 @@ namespace GeneTrail
 		log_median_fold_quotient(InputIterator1 begin1, InputIterator1 end1,
 		                         InputIterator2 begin2, InputIterator2 end2)
 		{
-			return std::log(median<value_type, InputIterator1>(begin1, end1)) -
-			       std::log(median<value_type, InputIterator2>(begin2, end2));
+			std::vector<value_type> buffer;
+			return log_median_fold_quotient(begin1, end1, begin2, end2, buffer);
 		}
 
 		/**
@@ -523,6 +627,29 @@ namespace GeneTrail
 			       mean<value_type, InputIterator2>(begin2, end2);
 		}
 
+		/**
+		 * Median-Fold-Quotient
+		 * This function calculates median(a) /  median(b).
+		 *
+		 * @param begin1 InputIterator corresponding to the start of the first group.
+		 * @param end1   InputIterator corresponding to the end of the first group.
+		 * @param begin2 InputIterator corresponding to the start of the second group.
+		 * @param end2   InputIterator corresponding to the end of the second group.
+		 * @param buffer Scratch space that is reused for both groups.
+		 *
+		 * @return median(a) /  median(b)
+		 */
+		template <typename value_type, typename InputIterator1,
+		          typename InputIterator2>
+		value_type
+		median_fold_quotient(InputIterator1 begin1, InputIterator1 end1,
+		                     InputIterator2 begin2, InputIterator2 end2,
+		                     std::vector<value_type>& buffer)
+		{
+			return median_buffered(begin1, end1, buffer) /
+			       median_buffered(begin2, end2, buffer);
+		}
+
 		/**
 		 * Median-Fold-Quotient
 		 * This function calculates median(a) /  median(b).
@@ -540,8 +667,31 @@ namespace GeneTrail
 		median_fold_quotient(InputIterator1 begin1, InputIterator1 end1,
 		                     InputIterator2 begin2, InputIterator2 end2)
 		{
-			return median<value_type, InputIterator1>(begin1, end1) /
-			       median<value_type, InputIterator2>(begin2, end2);
+			std::vector<value_type> buffer;
+			return median_fold_quotient(begin1, end1, begin2, end2, buffer);
+		}
+
+		/**
+		 * Median-Fold-Difference
+		 * This function calculates median(a) -  median(b).
+		 *
+		 * @param begin1 InputIterator corresponding to the start of the first group.
+		 * @param end1   InputIterator corresponding to the end of the first group.
+		 * @param begin2 InputIterator corresponding to the start of the second group.
+		 * @param end2   InputIterator corresponding to the end of the second group.
+		 * @param buffer Scratch space that is reused for both groups.
+		 *
+		 * @return median(a) -  median(b)
+		 */
+		template <typename value_type, typename InputIterator1,
+		          typename InputIterator2>
+		value_type
+		median_fold_difference(InputIterator1 begin1, InputIterator1 end1,
+		                       InputIterator2 begin2, InputIterator2 end2,
+		                       std::vector<value_type>& buffer)
+		{
+			return median_buffered(begin1, end1, buffer) -
+			       median_buffered(begin2, end2, buffer);
 		}
 
 		/**
@@ -561,8 +711,8 @@ namespace GeneTrail
 		median_fold_difference(InputIterator1 begin1, InputIterator1 end1,
 		                       InputIterator2 begin2, InputIterator2 end2)
 		{
-			return median<value_type, InputIterator1>(begin1, end1) -
-			       median<value_type, InputIterator2>(begin2, end2);
+			std::vector<value_type> buffer;
+			return median_fold_difference(begin1, end1, begin2, end2, buffer);
 		}
 
 		/**
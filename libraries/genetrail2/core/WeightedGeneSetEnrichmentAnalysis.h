@@ -93,9 +93,10 @@ namespace GeneTrail
 		float_type sum(Indices::const_iterator it, Indices::const_iterator end) const
 		{
 			using namespace std;
+			const double* values = scores_.scores().data();
 			float_type result = 0.0;
 			for(; it != end; ++it) {
-				result += std::abs(scores_[*it].score());
+				result += std::abs(values[*it]);
 			}
 			return result;
 		}
@@ -146,18 +147,19 @@ namespace GeneTrail
 
 			const float_type NR_inv = 1.0 / sum(begin, end);
 			const float_type missv = 1.0 / (scores_.size() - category_size);
+			const double* values = scores_.scores().data();
 
 			float_type maxRS = 0.0;
 
 			float_type RS = -(*begin * missv);
 			float_type minRS = RS;
-			RS += NR_inv * std::abs(scores_[*begin].score());
+			RS += NR_inv * std::abs(values[*begin]);
 			maxRS = (maxRS > RS) ? maxRS : RS;
 			size_t lastIndex = *begin;
 			for(auto it = begin + 1; it != end; ++it) {
 				RS -= (*it - lastIndex - 1) * missv;
 				minRS = (minRS < RS) ? minRS : RS;
-				RS += NR_inv * std::abs(scores_[*it].score());
+				RS += NR_inv * std::abs(values[*it]);
 				maxRS = (maxRS > RS) ? maxRS : RS;
 
 				lastIndex = *it;
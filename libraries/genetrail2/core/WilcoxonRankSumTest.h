@@ -26,6 +26,8 @@
 
 #include <boost/math/distributions/normal.hpp>
 
+#include <vector>
+
 namespace GeneTrail
 {
 
@@ -63,64 +65,21 @@ template <typename ValueType> class GT2_EXPORT WilcoxonRankSumTest
 	test(const InputIterator1& first_begin, const InputIterator1& first_end,
 	     const InputIterator2& second_begin, const InputIterator2& second_end)
 	{
-		std::vector<std::pair<value_type, unsigned int>> r;
-
-		value_type rank_sum1 = 0;
-		value_type rank_sum2 = 0;
-
-		size_t size1 = 0;
-		for(auto iit = first_begin; iit != first_end; ++iit, ++size1) {
-			r.emplace_back(*iit, 0);
-		}
-
-		size_t size2 = 0;
-		for(auto iit = second_begin; iit != second_end; ++iit, ++size2) {
-			r.emplace_back(*iit, 1);
-		}
-
-		sort(r.begin(), r.end(), [](const std::pair<value_type, int>& a,
-		                            const std::pair<value_type, int>& b) {
-			return a.first < b.first;
-		});
-
-		size_t i = 0;
-		while(i < r.size()) {
-			unsigned int k = 0;
-			value_type rank = i + 1;
-			// Find ranks with same value
-			for(unsigned int j = i + 1; j < r.size(); ++j) {
-				if(r[j].first != r[i].first) {
-					break;
-				} else {
-					k += 1;
-				}
-			}
-
-			// Build median rank
-			if(k != 0) {
-				rank = ((value_type)(rank + rank + k)) / ((value_type)2.0);
-			}
+		values_.assign(first_begin, first_end);
+		const size_t size1 = values_.size();
+		values_.insert(values_.end(), second_begin, second_end);
+		const size_t size2 = values_.size() - size1;
 
-			// Add to rank sums
-			for(unsigned int l = i; l <= i + k; ++l) {
-				if(r[l].second == 0) {
-					rank_sum1 += rank;
-				} else {
-					rank_sum2 += rank;
-				}
-			}
+		ranks_.resize(values_.size());
+		statistic::ranks(values_.begin(), values_.end(), ranks_.begin(),
+		                 order_);
 
-			i += k + 1;
+		value_type rank_sum1 = 0;
+		for(size_t i = 0; i < size1; ++i) {
+			rank_sum1 += ranks_[i];
 		}
 
-		// std::cout << "R1: " << rank_sum1 << " n1: " << size1 << " R2: " <<
-		// rank_sum2 << " n2: " << size2 << std::endl;
-		// std::cout << "mu1: " << size1 * (size1 + size2 + 1) / 2.0 <<
-		// std::endl;
-		// std::cout << "mu2: " << size2 * (size1 + size2 + 1) / 2.0 <<
-		// std::endl;
 		score_ = computeZScore(rank_sum1, size1, size2);
-		// std::cout << "ZScore: " << score_ << std::endl;
 		return score_;
 	}
 
@@ -206,6 +165,11 @@ template <typename ValueType> class GT2_EXPORT WilcoxonRankSumTest
 	value_type tolerance_;
 	value_type score_;
 	bool enriched_;
+
+	// Scratch space of test(), kept to avoid allocations in repeated calls.
+	std::vector<value_type> values_;
+	std::vector<double> ranks_;
+	std::vector<size_t> order_;
 };
 }
 
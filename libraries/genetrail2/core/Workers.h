@@ -0,0 +1,152 @@
+/*
+ * GeneTrail2 - An efficient library for interpreting genetic data
+ * Copyright (C) 2016 Daniel Stöckel <dstoeckel@bioinf.uni-sb.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Lesser GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Lesser GNU General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef GT2_CORE_WORKERS_H
+#define GT2_CORE_WORKERS_H
+
+#include <boost/optional.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace GeneTrail
+{
+namespace internal
+{
+	/**
+	 * Calls f(t) for every t in [0, numThreads). The first call is
+	 * executed on the calling thread, all others on a separate thread.
+	 * Exceptions thrown by any worker are rethrown after all threads
+	 * have been joined.
+	 */
+	template <typename Function>
+	void runWorkers(size_t numThreads, Function f)
+	{
+		std::vector<std::exception_ptr> errors(numThreads);
+
+		auto guarded = [&f, &errors](size_t t) {
+			try {
+				f(t);
+			} catch(...) {
+				errors[t] = std::current_exception();
+			}
+		};
+
+		std::vector<std::thread> threads;
+		threads.reserve(numThreads);
+		for(size_t t = 1; t < numThreads; ++t) {
+			threads.emplace_back(guarded, t);
+		}
+
+		guarded(0);
+
+		for(auto& thread : threads) {
+			thread.join();
+		}
+
+		for(const auto& error : errors) {
+			if(error) {
+				std::rethrow_exception(error);
+			}
+		}
+	}
+
+	/**
+	 * A queue with a fixed capacity that connects a producing and a
+	 * consuming thread. The producer blocks as long as the queue is full,
+	 * the consumer as long as it is empty.
+	 */
+	template <typename T> class BoundedQueue
+	{
+		public:
+		explicit BoundedQueue(size_t capacity) : capacity_(capacity) {}
+
+		/**
+		 * Appends value to the queue.
+		 *
+		 * @return false if the queue was closed, in which case value
+		 *         is discarded.
+		 */
+		bool push(T value)
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			not_full_.wait(lock, [this]() {
+				return closed_ || queue_.size() < capacity_;
+			});
+
+			if(closed_) {
+				return false;
+			}
+
+			queue_.push_back(std::move(value));
+			not_empty_.notify_one();
+
+			return true;
+		}
+
+		/**
+		 * Removes and returns the first element of the queue.
+		 *
+		 * @return boost::none if the queue is empty and was closed.
+		 */
+		boost::optional<T> pop()
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			not_empty_.wait(lock,
+			                [this]() { return closed_ || !queue_.empty(); });
+
+			if(queue_.empty()) {
+				return boost::none;
+			}
+
+			boost::optional<T> value(std::move(queue_.front()));
+			queue_.pop_front();
+			not_full_.notify_one();
+
+			return value;
+		}
+
+		/**
+		 * Closes the queue. Elements that are already contained can
+		 * still be popped, but no new elements are accepted.
+		 */
+		void close()
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			closed_ = true;
+			not_full_.notify_all();
+			not_empty_.notify_all();
+		}
+
+		private:
+		size_t capacity_;
+		bool closed_ = false;
+		std::deque<T> queue_;
+		std::mutex mutex_;
+		std::condition_variable not_full_;
+		std::condition_variable not_empty_;
+	};
+}
+}
+
+#endif // GT2_CORE_WORKERS_H
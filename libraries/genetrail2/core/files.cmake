@@ -31,18 +31,24 @@ add_header_to_library(WilcoxonMatchedPairsSignedRankTest.h)
 add_header_to_library(WilcoxonRankSumTest.h)
 add_header_to_library(AndersonDarlingTest.h)
 add_header_to_library(NormalityTest.h)
+add_header_to_library(RowMedians.h)
+add_header_to_library(RowMoments.h)
 add_header_to_library(WeightedGeneSetEnrichmentAnalysis.h)
+add_header_to_library(Workers.h)
 
 # Sources
 add_to_library(AbstractMatrix)
+add_to_library(BatchOverRepresentationAnalysis)
 add_to_library(BoostGraphProcessor)
 add_to_library(Category)
 add_to_library(CategoryDatabase)
+add_to_library(ConcurrentEntityDatabase)
 add_to_library(DenseColumnSubset)
 add_to_library(DenseMatrix)
 add_to_library(DenseMatrixReader)
 add_to_library(DenseMatrixWriter)
 add_to_library(DenseRowSubset)
+add_to_library(EntityBitset)
 add_to_library(EntityDatabase)
 add_to_library(Exception)
 add_to_library(File)
@@ -56,7 +62,10 @@ add_to_library(GEOGDSParser)
 add_to_library(GEOGPLParser)
 add_to_library(GEOGSEParser)
 add_to_library(GMTFile)
+add_to_library(HypergeometricDistribution)
 add_to_library(JsonCategoryFile)
+add_to_library(KolmogorovSmirnovPValueCache)
+add_to_library(LogFactorialTable)
 add_to_library(MatrixHTest)
 add_to_library(MatrixWriter)
 add_to_library(Metadata)
@@ -64,6 +73,7 @@ add_to_library(misc_algorithms)
 add_to_library(Path)
 add_to_library(Pathfinder)
 add_to_library(PValue)
+add_to_library(ReplacingFileWriter)
 add_to_library(RMAExpressMatrixReader)
 add_to_library(Scores)
 add_to_library(SparseMatrix)
@@ -47,11 +47,15 @@ namespace GeneTrail {
 			("adjustment,a",   value(&p.adjustment)->default_value(boost::none, "none"), "P-value adjustment method for multiple testing.")
 			("adjust_separately,u", value(&p.adjustSeparately)->default_value(false)->zero_tokens(), "Indicates if databases are adjusted separatly or combined.")
 			("pvalue_strategy,l",   value(&p.pValueMode)->default_value(PValueMode::RowWise, "row-wise"), "How should p-values be computed. Possible choices are 'row-wise', 'column-wise', and 'restandardize'")
-			("permutations,p",      value(&p.numPermutations)->default_value(1000000), "If p-values are computed using a permutation test, how many permutations should be used.")
+			("permutations,p",      value(&p.numPermutations)->default_value(1000000), "If p-values are computed using a permutation test, how many permutations should be used. The number of permutations that were actually used for a category is written to the last column (Permutations) of the result files. It is 0 if the p-value was not computed by a permutation test.")
 			("data_matrix_path,d",  value(&p.dataMatrixPath_), "If p-values are computed not using the row-wise strategy, a data matrix must be specified from which scores can be computed.")
 			("groups,g",            value(&p.groups_), "If p-values are computed not using the 'row-wise' strategy, this file determines the samples used for sample and reference group.")
 			("scoring_method,r",    value(&p.scoringMethod), "If p-values are computed not using the 'row-wise' strategy, a scoring method must be provided with which scores should be computed.")
 			("seed,e",              value(&p.randomSeed), "If p-values are computed using a permutation test, this option can be used for providing a seed for the random number generator.")
+			("threads,j",           value(&p.numThreads)->default_value(1), "The number of threads used for scoring the categories, for permutation tests and for computing the p-values of the Kolmogorov-Smirnov statistic in batches. Results are reproducible for a fixed seed and number of threads.")
+			("early_stopping,k",    value(&p.earlyStoppingHits)->default_value(0), "If p-values are computed using a permutation test, stop permuting a category as soon as this many permutations yielded a more extreme score. 0 disables early stopping.")
+			("null_distributions",  value(&p.nullDistributions), "A file containing precomputed null distributions. If p-values are computed using a row-wise permutation test, categories whose null distribution is contained in the file are looked up instead of being permuted.")
+			("build_null_distributions", value(&p.buildNullDistributions)->default_value(false)->zero_tokens(), "Sample the null distributions of all category sizes and add them to the file given by --null_distributions.")
 		;
 	}
 
@@ -78,6 +82,16 @@ namespace GeneTrail {
 			return false;
 		}
 
+		if(p.numThreads == 0) {
+			std::cerr << "ERROR: the number of threads must be at least one." << std::endl;
+			return false;
+		}
+
+		if(p.buildNullDistributions && p.nullDistributions.empty()) {
+			std::cerr << "ERROR: --build_null_distributions requires --null_distributions." << std::endl;
+			return false;
+		}
+
 		if(p.minimum > p.maximum) {
 			std::cerr << "WARNING: minimum category size is larger than maximum category size." << std::endl;
 		}
@@ -40,6 +40,13 @@ namespace GeneTrail
 		PValueMode pValueMode() const { return mode_; }
 		bool pValuesComputed() const;
 
+		/**
+		 * Create an independent copy of the algorithm. This is needed
+		 * whenever multiple threads need to modify the state of the
+		 * algorithm, e.g. by setting permuted scores.
+		 */
+		virtual std::unique_ptr<EnrichmentAlgorithm> clone() const = 0;
+
 		virtual bool canUseCategory(const Category& c, size_t hits) const = 0;
 		virtual bool rowWisePValueIsDirect() const = 0;
 		virtual bool supportsIndices() const = 0;
@@ -56,6 +63,33 @@ namespace GeneTrail
 		virtual std::tuple<double, double>
 		computeEnrichmentScore(IndexIterator begin, IndexIterator end) = 0;
 
+		/**
+		 * Computes the enrichment scores of a block of sorted index ranges
+		 * [begins[b], begins[b] + length) with a single call. This avoids
+		 * a virtual call per range and allows the statistic to evaluate
+		 * all ranges in an interleaved fashion. Only the first entry of the
+		 * returned tuples of computeEnrichmentScore is computed.
+		 *
+		 * @param begins Iterators pointing to the beginning of the ranges.
+		 * @param length The number of indices in every range.
+		 * @param scores Receives the score of the b-th range in scores[b].
+		 */
+		virtual void
+		computeEnrichmentScores(const std::vector<IndexIterator>& begins,
+		                        size_t length, std::vector<double>& scores) = 0;
+
+		/**
+		 * Computes the row-wise p-values of all results of a database at
+		 * once. This only does something for statistics that are able to
+		 * share work between the categories. All other statistics compute
+		 * their p-values in computeEnrichment.
+		 *
+		 * @param results    The results returned by computeEnrichment.
+		 * @param numThreads The number of threads that may be used.
+		 */
+		virtual void computeRowWisePValues(const EnrichmentResults& results,
+		                                   size_t numThreads) = 0;
+
 		private:
 		PValueMode mode_;
 	};
@@ -75,6 +109,11 @@ namespace GeneTrail
 			{
 			}
 
+			std::unique_ptr<EnrichmentAlgorithm> clone() const override
+			{
+				return std::make_unique<EnrichmentWorker>(*this);
+			}
+
 			void setScores(const Scores& scores) override
 			{
 				setScoresDispatch_(scores, typename Statistics::InputType());
@@ -99,6 +138,26 @@ namespace GeneTrail
 				    typename Statistics::SupportsIndices(), begin, end);
 			}
 
+			void
+			computeEnrichmentScores(const std::vector<IndexIterator>& begins,
+			                        size_t length,
+			                        std::vector<double>& scores) override
+			{
+				computeEnrichmentScoresDispatch_(
+				    typename Statistics::SupportsIndices(), begins, length,
+				    scores);
+			}
+
+			void computeRowWisePValues(const EnrichmentResults& results,
+			                           size_t numThreads) override
+			{
+				if(pValuesComputed()) {
+					computeRowWisePValuesDispatch_(
+					    results, numThreads,
+					    typename Statistics::RowWiseMode());
+				}
+			}
+
 			std::unique_ptr<EnrichmentResult>
 			computeEnrichment(const std::shared_ptr<Category>& c) override
 			{
@@ -151,6 +210,27 @@ namespace GeneTrail
 			{
 			}
 
+			void computePValueDispatch_(EnrichmentResult*, StatTags::Batched)
+			{
+			}
+
+			void computeRowWisePValuesDispatch_(const EnrichmentResults&,
+			                                    size_t, StatTags::Direct)
+			{
+			}
+
+			void computeRowWisePValuesDispatch_(const EnrichmentResults&,
+			                                    size_t, StatTags::Indirect)
+			{
+			}
+
+			void computeRowWisePValuesDispatch_(const EnrichmentResults& results,
+			                                    size_t numThreads,
+			                                    StatTags::Batched)
+			{
+				statistics_.computeRowWisePValues(results, numThreads);
+			}
+
 			bool rowWisePValueIsDirectDispatch_(StatTags::Direct) const
 			{
 				return true;
@@ -161,6 +241,11 @@ namespace GeneTrail
 				return false;
 			}
 
+			bool rowWisePValueIsDirectDispatch_(StatTags::Batched) const
+			{
+				return true;
+			}
+
 			bool supportsIndicesDispatch_(StatTags::SupportsIndices) const
 			{
 				return true;
@@ -202,6 +287,24 @@ namespace GeneTrail
 				                     "indices.");
 			}
 
+			void computeEnrichmentScoresDispatch_(
+			    StatTags::SupportsIndices,
+			    const std::vector<IndexIterator>& begins, size_t length,
+			    std::vector<double>& scores)
+			{
+				statistics_.computeScores(begins, length, scores);
+			}
+
+			void computeEnrichmentScoresDispatch_(
+			    StatTags::DoesNotSupportIndices,
+			    const std::vector<IndexIterator>&, size_t, std::vector<double>&)
+			{
+				throw NotImplemented(__FILE__, __LINE__,
+				                     "This type does not implement the "
+				                     "computation of enrichment scores using "
+				                     "indices.");
+			}
+
 			Statistics statistics_;
 		};
 	}
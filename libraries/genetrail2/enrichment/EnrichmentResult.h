@@ -21,11 +21,14 @@
 #define GT2_CORE_ENRICHMENT_RESULT_H
 
 #include <genetrail2/core/Category.h>
+#include <genetrail2/core/EntityDatabase.h>
 #include <genetrail2/core/macros.h>
 #include <genetrail2/core/multiprecision.h>
 
+#include <algorithm>
 #include <ostream>
 #include <string>
+#include <vector>
 
 namespace GeneTrail
 {
@@ -40,17 +43,48 @@ namespace GeneTrail
 		      pvalue(1.0),
 		      enriched(false),
 		      score(0.0),
-		      expected_score(0.0)
+		      expected_score(0.0),
+		      permutations(0)
 		{
 		}
 
 		std::shared_ptr<Category> category;
 		unsigned int hits;
 		big_float pvalue;
-		std::string info;
+		/// The sorted entity ids of the hits. They are only converted to
+		/// names when the result is serialized.
+		std::vector<size_t> hit_ids;
 		bool enriched;
 		double score;
 		double expected_score;
+		/// Number of permutations that were used for computing the p-value.
+		/// This is smaller than the requested number if the category was
+		/// retired early by a sequential permutation test.
+		size_t permutations;
+
+		/**
+		 * Writes the comma-separated, alphabetically sorted names of the
+		 * hits to strm.
+		 */
+		void writeInfo(std::ostream& strm) const
+		{
+			const auto& db = *category->entityDatabase();
+
+			std::vector<EntityDatabase::NameRef> names;
+			names.reserve(hit_ids.size());
+			for(auto id : hit_ids) {
+				names.push_back(db.name(id));
+			}
+
+			std::sort(names.begin(), names.end());
+
+			for(size_t i = 0; i < names.size(); ++i) {
+				if(i != 0) {
+					strm << ',';
+				}
+				strm << names[i];
+			}
+		}
 
 		virtual std::string header() const
 		{
@@ -62,7 +96,8 @@ namespace GeneTrail
 			header += "Expected Score\t";
 			header += "P-value\t";
 			header += "Info\t";
-			header += "Regulation_direction";
+			header += "Regulation_direction\t";
+			header += "Permutations";
 			return header;
 		}
 
@@ -73,9 +108,9 @@ namespace GeneTrail
 			     << hits << '\t'
 			     << score << '\t'
 			     << expected_score << '\t'
-			     << pvalue << '\t'
-			     << info << '\t'
-			     << enriched;
+			     << pvalue << '\t';
+			writeInfo(strm);
+			strm << '\t' << enriched << '\t' << permutations;
 		}
 	};
 
@@ -0,0 +1,200 @@
+/*
+ * GeneTrail2 - An efficient library for interpreting genetic data
+ * Copyright (C) 2016 Daniel Stöckel <dstoeckel@bioinf.uni-sb.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Lesser GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Lesser GNU General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "NullDistributionCache.h"
+
+#include <genetrail2/core/Exception.h>
+#include <genetrail2/core/ReplacingFileWriter.h>
+#include <genetrail2/core/Scores.h>
+
+#include <algorithm>
+#include <cstring>
+#include <tuple>
+#include <vector>
+
+namespace GeneTrail
+{
+	namespace
+	{
+		const char MAGIC[8] = {'G', 'T', '2', 'N', 'U', 'L', 'L', '1'};
+
+		// 64 bit FNV-1a hash
+		uint64_t hashBytes(const void* data, size_t size,
+		                   uint64_t hash = 14695981039346656037ull)
+		{
+			auto bytes = static_cast<const unsigned char*>(data);
+			for(size_t i = 0; i < size; ++i) {
+				hash ^= bytes[i];
+				hash *= 1099511628211ull;
+			}
+			return hash;
+		}
+	}
+
+	NullDistributionKey::NullDistributionKey()
+	    : n(0), hits(0), statistic(0), order(0), scores(0)
+	{
+	}
+
+	NullDistributionKey::NullDistributionKey(const std::string& statistic,
+	                                         uint64_t order,
+	                                         const Scores& scores)
+	    : n(scores.size()),
+	      hits(0),
+	      statistic(hashBytes(statistic.data(), statistic.size())),
+	      order(order),
+	      scores(hashBytes(nullptr, 0))
+	{
+		// Permuting the scores only moves the values between the
+		// entities, so the distribution does not depend on the entities
+		// the values belong to nor on the order of the scores.
+		std::vector<double> values(scores.scores().begin(),
+		                           scores.scores().end());
+		std::sort(values.begin(), values.end());
+
+		for(double value : values) {
+			this->scores = hashBytes(&value, sizeof(value), this->scores);
+		}
+	}
+
+	bool operator<(const NullDistributionKey& a, const NullDistributionKey& b)
+	{
+		return std::tie(a.n, a.hits, a.statistic, a.order, a.scores) <
+		       std::tie(b.n, b.hits, b.statistic, b.order, b.scores);
+	}
+
+	NullDistributionCache::NullDistributionCache(const std::string& path)
+	{
+		try {
+			file_.open(path);
+		} catch(const std::exception& e) {
+			throw IOError("Could not open null distribution file '" + path +
+			              "': " + e.what());
+		}
+
+		const size_t headerSize = sizeof(MAGIC) + sizeof(uint64_t);
+		if(file_.size() < headerSize ||
+		   std::memcmp(file_.data(), MAGIC, sizeof(MAGIC)) != 0) {
+			throw IOError("'" + path + "' is not a null distribution file.");
+		}
+
+		uint64_t numEntries;
+		std::memcpy(&numEntries, file_.data() + sizeof(MAGIC),
+		            sizeof(numEntries));
+
+		// Bound the number of entries by the file size before multiplying
+		// it, which also keeps it below SIZE_MAX / sizeof(Entry). A corrupt
+		// header thus cannot wrap the offset around.
+		if(numEntries > (file_.size() - headerSize) / sizeof(Entry)) {
+			throw IOError("The null distribution file '" + path +
+			              "' is truncated.");
+		}
+
+		const size_t dataOffset = headerSize + numEntries * sizeof(Entry);
+		if((file_.size() - dataOffset) % sizeof(double) != 0) {
+			throw IOError("The null distribution file '" + path +
+			              "' is corrupt.");
+		}
+
+		numEntries_ = numEntries;
+		entries_ = reinterpret_cast<const Entry*>(file_.data() + headerSize);
+		data_ = reinterpret_cast<const double*>(file_.data() + dataOffset);
+		dataSize_ = (file_.size() - dataOffset) / sizeof(double);
+
+		for(size_t i = 0; i < numEntries_; ++i) {
+			if(entries_[i].offset > dataSize_ ||
+			   entries_[i].count > dataSize_ - entries_[i].offset) {
+				throw IOError("The null distribution file '" + path +
+				              "' is truncated.");
+			}
+
+			// find() relies on the entries being sorted by their key.
+			if(i > 0 && !(entries_[i - 1].key < entries_[i].key)) {
+				throw IOError("The null distribution file '" + path +
+				              "' is corrupt.");
+			}
+		}
+	}
+
+	std::pair<const double*, const double*>
+	NullDistributionCache::find(const NullDistributionKey& key) const
+	{
+		auto end = entries_ + numEntries_;
+		auto it = std::lower_bound(
+		    entries_, end, key,
+		    [](const Entry& e, const NullDistributionKey& k) { return e.key < k; });
+
+		if(it == end || key < it->key) {
+			return std::make_pair(nullptr, nullptr);
+		}
+
+		auto begin = data_ + it->offset;
+		return std::make_pair(begin, begin + it->count);
+	}
+
+	void NullDistributionCache::read(Distributions& dists) const
+	{
+		for(size_t i = 0; i < numEntries_; ++i) {
+			const auto& entry = entries_[i];
+			auto begin = data_ + entry.offset;
+			dists.emplace(entry.key,
+			              std::vector<double>(begin, begin + entry.count));
+		}
+	}
+
+	void NullDistributionCache::write(const std::string& path,
+	                                  Distributions& dists)
+	{
+		// The file may be mapped by other processes, so it must not be
+		// truncated in place.
+		ReplacingFileWriter writer(path);
+		auto& strm = writer.stream();
+
+		uint64_t numEntries = dists.size();
+		strm.write(MAGIC, sizeof(MAGIC));
+		strm.write(reinterpret_cast<const char*>(&numEntries),
+		           sizeof(numEntries));
+
+		// As dists is a std::map, the entries are written in sorted order.
+		uint64_t offset = 0;
+		for(auto& dist : dists) {
+			std::sort(dist.second.begin(), dist.second.end());
+
+			Entry entry;
+			entry.key = dist.first;
+			entry.offset = offset;
+			entry.count = dist.second.size();
+			strm.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+
+			offset += entry.count;
+		}
+
+		for(const auto& dist : dists) {
+			strm.write(reinterpret_cast<const char*>(dist.second.data()),
+			           dist.second.size() * sizeof(double));
+		}
+
+		if(!strm) {
+			throw IOError("Could not write null distributions to '" + path +
+			              "'.");
+		}
+
+		writer.commit();
+	}
+}
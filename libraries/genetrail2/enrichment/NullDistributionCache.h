@@ -0,0 +1,136 @@
+/*
+ * GeneTrail2 - An efficient library for interpreting genetic data
+ * Copyright (C) 2016 Daniel Stöckel <dstoeckel@bioinf.uni-sb.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Lesser GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Lesser GNU General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef GT2_ENRICHMENT_NULL_DISTRIBUTION_CACHE_H
+#define GT2_ENRICHMENT_NULL_DISTRIBUTION_CACHE_H
+
+#include <genetrail2/core/macros.h>
+
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace GeneTrail
+{
+	class Scores;
+
+	/**
+	 * Identifies a null distribution of a row-wise permutation test.
+	 *
+	 * The distribution of the permuted scores only depends on the number
+	 * of scores n, the number of hits of the category, the statistic and
+	 * the sort order used by the statistic. Most statistics additionally
+	 * depend on the values of the scores, which are summarised by a
+	 * fingerprint of the sorted score values.
+	 */
+	struct GT2_EXPORT NullDistributionKey
+	{
+		NullDistributionKey();
+
+		/**
+		 * Creates the key for the given scores with zero hits.
+		 *
+		 * @param statistic A string identifying the statistic, e.g. the
+		 *                  name of the method on the command line.
+		 * @param order     The sort order of the statistic or zero if
+		 *                  the statistic does not use one.
+		 * @param scores    The scores the statistic is computed on.
+		 */
+		NullDistributionKey(const std::string& statistic, uint64_t order,
+		                    const Scores& scores);
+
+		uint64_t n;
+		uint64_t hits;
+		uint64_t statistic;
+		uint64_t order;
+		uint64_t scores;
+	};
+
+	GT2_EXPORT bool operator<(const NullDistributionKey& a,
+	                          const NullDistributionKey& b);
+
+	/**
+	 * A read-only, memory-mapped file of precomputed null distributions.
+	 *
+	 * The file starts with a magic number and the number of entries,
+	 * followed by the entry table sorted by key and the sorted permuted
+	 * scores of all entries. As the file is mapped into memory, multiple
+	 * processes using the same file share the pages and looking up a
+	 * distribution only needs a binary search over the entry table.
+	 */
+	class GT2_EXPORT NullDistributionCache
+	{
+		public:
+		using Distributions =
+		    std::map<NullDistributionKey, std::vector<double>>;
+
+		/**
+		 * Maps the given file into memory.
+		 *
+		 * @throws IOError if the file cannot be opened or is invalid.
+		 */
+		explicit NullDistributionCache(const std::string& path);
+
+		/**
+		 * Looks up the sorted null distribution for the given key.
+		 *
+		 * @return A pair of pointers delimiting the permuted scores or a
+		 *         pair of null pointers if the key is not contained.
+		 */
+		std::pair<const double*, const double*>
+		find(const NullDistributionKey& key) const;
+
+		/// The number of distributions in the file.
+		size_t size() const { return numEntries_; }
+
+		/**
+		 * Copies all distributions into dists. Existing entries of dists
+		 * are kept.
+		 */
+		void read(Distributions& dists) const;
+
+		/**
+		 * Writes the distributions into the given file. The values of every
+		 * distribution are sorted in the process.
+		 *
+		 * @throws IOError if the file cannot be written.
+		 */
+		static void write(const std::string& path, Distributions& dists);
+
+		private:
+		struct Entry
+		{
+			NullDistributionKey key;
+			uint64_t offset;
+			uint64_t count;
+		};
+
+		boost::iostreams::mapped_file_source file_;
+		const Entry* entries_;
+		size_t numEntries_;
+		const double* data_;
+		size_t dataSize_;
+	};
+}
+
+#endif // GT2_ENRICHMENT_NULL_DISTRIBUTION_CACHE_H
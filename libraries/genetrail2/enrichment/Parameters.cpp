@@ -27,6 +27,9 @@ Params::Params()
 	maximum(700),
 	numPermutations(100000),
 	randomSeed(std::random_device{}()),
+	numThreads(1),
+	earlyStoppingHits(0),
+	buildNullDistributions(false),
 	adjustSeparately(false),
 	pValueMode(PValueMode::RowWise)
 	{
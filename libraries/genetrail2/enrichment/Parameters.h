@@ -90,6 +90,14 @@ namespace GeneTrail {
 		size_t maximum;
 		size_t numPermutations;
 		size_t randomSeed;
+		size_t numThreads;
+		size_t earlyStoppingHits;
+
+		std::string nullDistributions;
+		bool buildNullDistributions;
+		/// Identifies the statistic in the keys of the null distributions.
+		/// Null distributions are only used if this is set.
+		std::string statistic;
 
 		bool adjustSeparately;
 
@@ -22,16 +22,19 @@
 
 #include "EnrichmentAlgorithm.h"
 #include "EnrichmentResult.h"
+#include "NullDistributionCache.h"
 
 #include <genetrail2/core/macros.h>
 #include <genetrail2/core/misc_algorithms.h>
 #include <genetrail2/core/DenseColumnSubset.h>
 #include <genetrail2/core/DenseMatrix.h>
 #include <genetrail2/core/MatrixHTest.h>
+#include <genetrail2/core/Workers.h>
 
 #include <boost/iterator/counting_iterator.hpp>
 
 #include <algorithm>
+#include <functional>
 #include <vector>
 #include <utility>
 #include <random>
@@ -43,6 +46,22 @@ namespace internal
 {
 template <typename value_type> class PermutationBase
 {
+  public:
+	/**
+	 * Enables sequential early stopping of the permutation test as
+	 * proposed by Besag and Clifford. A category is no longer permuted
+	 * as soon as `hits` permutations yielded a score that is at least as
+	 * extreme as the observed one. This saves a large amount of work for
+	 * categories that are clearly not significant.
+	 *
+	 * Reference: Besag J., Clifford P., Sequential Monte Carlo p-values,
+	 * Biometrika 78 (1991), 301-304.
+	 *
+	 * @param hits The number of extreme permutations after which a
+	 *             category is retired. Zero disables early stopping.
+	 */
+	void setEarlyStoppingHits(size_t hits) { earlyStoppingHits_ = hits; }
+
   protected:
 	void printStatus_(size_t i, size_t count)
 	{
@@ -63,6 +82,17 @@ template <typename value_type> class PermutationBase
 		return ((double)counter + 1) / ((double)permutations);
 	}
 
+	/**
+	 * The p-value estimator for categories that have been retired after
+	 * `permutations` permutations with `counter` >= earlyStoppingHits_
+	 * extreme values. As we stopped sampling because the counter became
+	 * large, no pseudo count is needed here.
+	 */
+	double computeSequentialPValue_(size_t permutations, size_t counter) const
+	{
+		return std::min(1.0, (double)counter / (double)permutations);
+	}
+
 	void sortResults_(EnrichmentResults& results)
 	{
 		// Sort vector of EnrichmentResults
@@ -87,13 +117,112 @@ template <typename value_type> class PermutationBase
 		}
 	}
 
-	void updatePValues_(EnrichmentResults& tests,
-	                    const std::vector<size_t>& counter, size_t permutations)
+	/**
+	 * Drives the permutation test. If early stopping is disabled,
+	 * runRound(0, permutations) is called exactly once. Otherwise the
+	 * permutations are performed in rounds of fixed size. After every
+	 * round reduce(counter) must store the current number of extreme
+	 * permutations of every test in counter. Tests that exceeded the
+	 * threshold are marked as inactive and need not be evaluated by
+	 * the following rounds. The loop terminates as soon as all tests are
+	 * inactive or the permutation budget is exhausted.
+	 *
+	 * As rounds have a fixed size and the counters are only checked at the
+	 * end of a round, the results do not depend on thread scheduling.
+	 */
+	template <typename RunRound, typename Reduce>
+	void runAdaptive_(EnrichmentResults& tests, size_t permutations,
+	                  RunRound runRound, Reduce reduce)
 	{
+		// Number of permutations between two checks of the counters
+		const size_t roundSize =
+		    earlyStoppingHits_ == 0 ? permutations : 1000;
+
+		std::vector<size_t> counter(tests.size());
+		std::vector<size_t> used(tests.size(), permutations);
+		active_.assign(tests.size(), 1);
+
+		size_t numActive = tests.size();
+		for(size_t first = 0; first < permutations && numActive > 0;) {
+			auto count = std::min(roundSize, permutations - first);
+			runRound(first, count);
+			first += count;
+
+			if(earlyStoppingHits_ == 0) {
+				continue;
+			}
+
+			reduce(counter);
+			for(size_t i = 0; i < tests.size(); ++i) {
+				if(active_[i] && counter[i] >= earlyStoppingHits_) {
+					active_[i] = 0;
+					used[i] = first;
+					--numActive;
+				}
+			}
+		}
+
+		reduce(counter);
 		for(size_t i = 0; i < tests.size(); ++i) {
-			tests[i]->pvalue = computePValue_(permutations, counter[i]);
+			tests[i]->permutations = used[i];
+			tests[i]->pvalue =
+			    active_[i] ? computePValue_(permutations, counter[i])
+			               : computeSequentialPValue_(used[i], counter[i]);
+		}
+	}
+
+	/**
+	 * Sums up the counters of all workers.
+	 */
+	template <typename Workers>
+	void reduceCounters_(const Workers& workers, std::vector<size_t>& counter)
+	{
+		std::fill(counter.begin(), counter.end(), 0);
+		for(const auto& worker : workers) {
+			std::transform(counter.begin(), counter.end(),
+			               worker.counter.begin(), counter.begin(),
+			               std::plus<size_t>());
+		}
+	}
+
+	/**
+	 * Number of permutations that should be performed by worker t if
+	 * the total number of permutations is split across numThreads
+	 * workers.
+	 */
+	size_t workerPermutations_(size_t permutations, size_t numThreads,
+	                           size_t t) const
+	{
+		return permutations / numThreads +
+		       (t < permutations % numThreads ? 1 : 0);
+	}
+
+	/**
+	 * Derives the seed for the random number generator of worker t.
+	 * The first worker uses the user supplied seed, all other workers
+	 * obtain a seed that is scrambled using std::seed_seq.
+	 */
+	uint64_t workerSeed_(uint64_t randomSeed, size_t t) const
+	{
+		if(t == 0) {
+			return randomSeed;
 		}
+
+		std::seed_seq seq{static_cast<uint32_t>(randomSeed),
+		                  static_cast<uint32_t>(randomSeed >> 32),
+		                  static_cast<uint32_t>(t)};
+
+		uint32_t seed[2];
+		seq.generate(seed, seed + 2);
+
+		return (static_cast<uint64_t>(seed[1]) << 32) | seed[0];
 	}
+
+	size_t earlyStoppingHits_ = 0;
+
+	// Indicates which tests still need to be evaluated. This is only
+	// modified in between two rounds of permutations.
+	std::vector<char> active_;
 };
 }
 
@@ -103,21 +232,50 @@ class GT2_EXPORT RowPermutationTest
 {
   public:
 	static std::unique_ptr<RowPermutationTest>
-	IndexBased(const Scores& s, size_t permutations, uint64_t randomSeed)
+	IndexBased(const Scores& s, size_t permutations, uint64_t randomSeed,
+	           size_t numThreads = 1)
 	{
-		return std::unique_ptr<RowPermutationTest>(
-		    new RowPermutationTest(boost::counting_iterator<size_t>(0),
-		                           boost::counting_iterator<size_t>(s.size()),
-		                           permutations, randomSeed));
+		return std::unique_ptr<RowPermutationTest>(new RowPermutationTest(
+		    boost::counting_iterator<size_t>(0),
+		    boost::counting_iterator<size_t>(s.size()), permutations,
+		    randomSeed, numThreads));
 	}
 
 	static std::unique_ptr<RowPermutationTest>
-	CategoryBased(const Scores& s, size_t permutations, uint64_t randomSeed)
+	CategoryBased(const Scores& s, size_t permutations, uint64_t randomSeed,
+	              size_t numThreads = 1)
 	{
-		return std::unique_ptr<RowPermutationTest>(new RowPermutationTest(
-		    s.indices().begin(), s.indices().end(), permutations, randomSeed));
+		return std::unique_ptr<RowPermutationTest>(
+		    new RowPermutationTest(s.indices().begin(), s.indices().end(),
+		                           permutations, randomSeed, numThreads));
+	}
+
+	/**
+	 * Uses precomputed null distributions instead of sampling permutations
+	 * for all categories whose size is contained in the cache. The hits
+	 * member of the key is ignored. The cache must outlive all calls of
+	 * computePValue. Passing a null pointer disables the cache.
+	 */
+	void setNullDistributions(const NullDistributionCache* cache,
+	                          const NullDistributionKey& key)
+	{
+		cache_ = cache;
+		key_ = key;
 	}
 
+	/**
+	 * Computes the p-values of all tests. The permutations are distributed
+	 * evenly across all workers. Each worker owns its own random number
+	 * generator, scratch memory and clone of the enrichment algorithm, so
+	 * that no state is shared between the workers. The counters of the
+	 * workers are summed up afterwards.
+	 *
+	 * For a fixed seed and number of threads the results are reproducible.
+	 * They do not depend on the block size. The samples differ from those
+	 * drawn by versions before the permutations were scored in blocks, so
+	 * the p-values of a seeded run differ from those versions within the
+	 * accuracy of the permutation test.
+	 */
 	void computePValue(const EnrichmentAlgorithmPtr& algorithm,
 	                   EnrichmentResults& tests)
 	{
@@ -127,76 +285,329 @@ class GT2_EXPORT RowPermutationTest
 
 		this->sortResults_(tests);
 
-		std::vector<size_t> counter(tests.size());
-		for(size_t i = 0; i < permutations_; ++i) {
-			this->printStatus_(i, permutations_);
+		// Tests with a precomputed null distribution need not be permuted.
+		EnrichmentResults pending;
+		for(const auto& test : tests) {
+			if(!lookupPValue_(test)) {
+				pending.push_back(test);
+			}
+		}
 
-			performSinglePermutation_(algorithm, tests, counter);
+		if(pending.empty()) {
+			return;
 		}
 
-		this->updatePValues_(tests, counter, permutations_);
+		prepareWorkers_(algorithm, pending.size());
+
+		size_t statusDone = 0;
+		auto runRound = [&](size_t, size_t count) {
+			runPermutations_(
+			    pending, count, statusDone,
+			    [this, &pending](Worker& worker, size_t i, double score) {
+				    this->updateCounter_(pending[i], worker.counter[i], score);
+				});
+		};
+
+		this->runAdaptive_(pending, permutations_, runRound,
+		                   [this](std::vector<size_t>& counter) {
+			                   this->reduceCounters_(workers_, counter);
+			               });
+	}
+
+	/**
+	 * Samples the null distributions of the given category sizes using
+	 * all permutations.
+	 *
+	 * @param sizes The category sizes in strictly ascending order.
+	 *
+	 * @return The sorted permuted scores for every size.
+	 */
+	std::vector<std::vector<double>>
+	computeNullDistributions(const EnrichmentAlgorithmPtr& algorithm,
+	                         const std::vector<size_t>& sizes)
+	{
+		EnrichmentResults tests;
+		tests.reserve(sizes.size());
+		for(auto size : sizes) {
+			tests.push_back(std::make_shared<EnrichmentResult>(nullptr));
+			tests.back()->hits = size;
+		}
+
+		this->active_.assign(tests.size(), 1);
+		prepareWorkers_(algorithm, tests.size());
+
+		for(auto& worker : workers_) {
+			worker.null_scores.assign(tests.size(), std::vector<double>());
+		}
+
+		size_t statusDone = 0;
+		runPermutations_(tests, permutations_, statusDone,
+		                 [](Worker& worker, size_t i, double score) {
+			                 worker.null_scores[i].push_back(score);
+			             });
+
+		std::vector<std::vector<double>> result(tests.size());
+		for(size_t i = 0; i < tests.size(); ++i) {
+			for(auto& worker : workers_) {
+				result[i].insert(result[i].end(),
+				                 worker.null_scores[i].begin(),
+				                 worker.null_scores[i].end());
+				worker.null_scores[i].clear();
+			}
+
+			std::sort(result[i].begin(), result[i].end());
+		}
+
+		return result;
 	}
 
   private:
+	/**
+	 * The number of permutations that are scored together with a
+	 * single call of EnrichmentAlgorithm::computeEnrichmentScores.
+	 */
+	static constexpr size_t blockSize_ = 16;
+
+	/**
+	 * The state that is needed by a single thread for
+	 * performing its share of the permutations.
+	 */
+	struct Worker
+	{
+		template <typename InputIterator>
+		Worker(InputIterator begin, InputIterator end, uint64_t seed)
+		    : category(nullptr),
+		      twister(seed),
+		      indices(begin, end),
+		      tmp_indices(std::distance(begin, end))
+		{
+		}
+
+		Category category;
+		std::mt19937_64 twister;
+		/// The clone of the enrichment algorithm used by this worker.
+		EnrichmentAlgorithmPtr algorithm;
+		std::vector<size_t> indices;
+		std::vector<size_t> tmp_indices;
+		std::vector<size_t> counter;
+		std::vector<std::vector<double>> null_scores;
+
+		// The samples of the permutations in the current block
+		std::vector<std::vector<size_t>> block;
+		std::vector<IndexIterator> begins;
+		std::vector<double> scores;
+	};
+
 	template <typename InputIterator>
 	RowPermutationTest(InputIterator begin, InputIterator end,
-	                   size_t permutations, uint64_t randomSeed)
-	    : category_(nullptr),
-	      permutations_(permutations),
-	      twister_(randomSeed),
-	      indices_(begin, end),
-	      tmp_indices_(std::distance(begin, end))
+	                   size_t permutations, uint64_t randomSeed,
+	                   size_t numThreads)
+	    : permutations_(permutations)
+	{
+		numThreads = std::max<size_t>(1, std::min(numThreads, permutations));
+
+		workers_.reserve(numThreads);
+		for(size_t t = 0; t < numThreads; ++t) {
+			workers_.emplace_back(begin, end, this->workerSeed_(randomSeed, t));
+		}
+	}
+
+	void prepareWorkers_(const EnrichmentAlgorithmPtr& algorithm,
+	                     size_t numTests)
 	{
+		for(auto& worker : workers_) {
+			worker.algorithm = algorithm->clone();
+			worker.counter.assign(numTests, 0);
+		}
 	}
 
-	std::tuple<double, double>
-	computeEnrichmentScore_(const EnrichmentAlgorithmPtr& algorithm,
-	                        size_t currentSampleSize)
+	/**
+	 * Computes the p-value of the test from the precomputed null
+	 * distribution of its size.
+	 *
+	 * @return false if no null distribution is available.
+	 */
+	bool lookupPValue_(const EnrichmentResultPtr& test) const
 	{
-		auto start = indices_.begin();
-		auto stop = indices_.begin() + currentSampleSize;
+		if(cache_ == nullptr) {
+			return false;
+		}
+
+		auto key = key_;
+		key.hits = test->hits;
+
+		auto range = cache_->find(key);
+		if(range.first == nullptr) {
+			return false;
+		}
+
+		// Count the permuted scores that are at least as extreme as the
+		// observed one, exactly as updateCounter_ does.
+		size_t counter;
+		if(test->enriched) {
+			counter = range.second -
+			          std::lower_bound(range.first, range.second, test->score);
+		} else {
+			counter = std::upper_bound(range.first, range.second, test->score) -
+			          range.first;
+		}
+
+		test->permutations = range.second - range.first;
+		test->pvalue = this->computePValue_(test->permutations, counter);
+
+		return true;
+	}
+
+	/**
+	 * Performs count permutations distributed across all workers and
+	 * passes the score of every active test i to store(worker, i, score).
+	 */
+	template <typename Store>
+	void runPermutations_(const EnrichmentResults& tests, size_t count,
+	                      size_t& statusDone, Store store)
+	{
+		const auto numThreads = workers_.size();
+		const auto statusTotal =
+		    this->workerPermutations_(permutations_, numThreads, 0);
+
+		// The tests are sorted by the number of hits for every category,
+		// so we only need to shuffle as many indices as the largest
+		// active category contains.
+		size_t shuffleSize = 0;
+		for(size_t i = tests.size(); i > 0; --i) {
+			if(this->active_[i - 1]) {
+				shuffleSize = tests[i - 1]->hits;
+				break;
+			}
+		}
+
+		internal::runWorkers(numThreads, [&](size_t t) {
+			auto n = this->workerPermutations_(count, numThreads, t);
+
+			for(size_t i = 0; i < n; i += blockSize_) {
+				auto m = std::min(blockSize_, n - i);
+
+				// Only the first worker reports its progress, as
+				// the output of multiple threads would be garbled.
+				if(t == 0) {
+					for(size_t j = 0; j < m; ++j) {
+						this->printStatus_(statusDone + i + j, statusTotal);
+					}
+				}
+
+				performPermutationBlock_(workers_[t], tests, shuffleSize, m,
+				                         store);
+			}
+		});
+
+		statusDone += this->workerPermutations_(count, numThreads, 0);
+	}
+
+	/**
+	 * Computes the scores of the samples [begins[b], begins[b] +
+	 * currentSampleSize) of all permutations in the current block and
+	 * stores them in worker.scores.
+	 */
+	void computeEnrichmentScores_(Worker& worker, size_t currentSampleSize)
+	{
+		const auto& begins = worker.begins;
+		const auto& algorithm = worker.algorithm;
 
 		if(algorithm->supportsIndices()) {
-			return algorithm->computeEnrichmentScore(start, stop);
+			algorithm->computeEnrichmentScores(begins, currentSampleSize,
+			                                   worker.scores);
 		} else {
-			category_.replaceAll(start, stop);
-			return algorithm->computeEnrichmentScore(category_);
+			worker.scores.resize(begins.size());
+			for(size_t b = 0; b < begins.size(); ++b) {
+				worker.category.replaceAll(begins[b],
+				                           begins[b] + currentSampleSize);
+				worker.scores[b] = std::get<0>(
+				    algorithm->computeEnrichmentScore(worker.category));
+			}
 		}
 	}
 
-	void performSinglePermutation_(const EnrichmentAlgorithmPtr& algorithm,
-	                               const EnrichmentResults& tests,
-	                               std::vector<size_t>& counter)
+	/**
+	 * Prepares the samples for numPermutations permutations.
+	 */
+	void startBlock_(Worker& worker, size_t shuffleSize,
+	                 size_t numPermutations)
 	{
-		size_t currentSampleSize = 0;
-		value_type currentScore = 0.0;
+		worker.begins.resize(numPermutations);
+
+		auto& indices = worker.indices;
+
+		// The prefixes are sorted on their copies, so every shuffle starts
+		// from the state the previous one left behind. As a partial
+		// Fisher-Yates shuffle draws uniform samples from any starting
+		// order, the indices need not be restored in between. The samples
+		// thus only depend on the seed and not on the block size.
+		worker.block.resize(numPermutations);
+		for(auto& prefix : worker.block) {
+			shuffle_(worker, shuffleSize);
+			prefix.assign(indices.begin(), indices.begin() + shuffleSize);
+		}
+	}
+
+	/**
+	 * Grows the sorted samples of all permutations in the current block
+	 * from size a to size b and updates worker.begins.
+	 */
+	void growBlock_(Worker& worker, size_t a, size_t b)
+	{
+		for(size_t i = 0; i < worker.begins.size(); ++i) {
+			auto& prefix = worker.block[i];
+			presort_(prefix, worker.tmp_indices, a, b);
+			worker.begins[i] = prefix.cbegin();
+		}
+	}
 
-		// Shuffle the indices. The tests are sorted
-		// by the number of hits for every category, so we only
-		// need to shuffle tests.back()->hits many.
-		shuffle_(tests.back()->hits);
+	/**
+	 * Performs numPermutations permutations at once. First, the
+	 * samples of all permutations are prepared. Afterwards, the scores of
+	 * all permutations are computed for one category size at a time.
+	 */
+	template <typename Store>
+	void performPermutationBlock_(Worker& worker,
+	                              const EnrichmentResults& tests,
+	                              size_t shuffleSize, size_t numPermutations,
+	                              Store& store)
+	{
+		startBlock_(worker, shuffleSize, numPermutations);
+
+		size_t currentSampleSize = 0;
+		worker.scores.assign(numPermutations, 0.0);
 
 		for(size_t i = 0; i < tests.size(); ++i) {
+			// Categories that have been retired by the early stopping
+			// criterion are skipped. If all categories of a certain size
+			// are inactive, no score needs to be computed for that size.
+			if(!this->active_[i]) {
+				continue;
+			}
+
 			// Check if the sampleSize has changed. As the tests_ vector is
 			// sorted we can use one running sum value for all categories of
 			// the same size.
 			if(tests[i]->hits != currentSampleSize) {
-				presort_(currentSampleSize, tests[i]->hits);
+				growBlock_(worker, currentSampleSize, tests[i]->hits);
 				currentSampleSize = tests[i]->hits;
 
-				currentScore = std::get<0>(
-				    computeEnrichmentScore_(algorithm, currentSampleSize));
+				computeEnrichmentScores_(worker, currentSampleSize);
 			}
 
-			this->updateCounter_(tests[i], counter[i], currentScore);
+			for(const auto& score : worker.scores) {
+				store(worker, i, score);
+			}
 		}
 	}
 
-	void shuffle_(size_t n)
+	void shuffle_(Worker& worker, size_t n)
 	{
+		auto& indices = worker.indices;
 		for(size_t i = 0; i < n; ++i) {
-			std::swap(indices_[i],
-			          indices_[i + twister_() % (indices_.size() - i)]);
+			std::swap(indices[i],
+			          indices[i + worker.twister() % (indices.size() - i)]);
 		}
 	}
 
@@ -204,63 +615,92 @@ class GT2_EXPORT RowPermutationTest
 	 * This sorts the indices vector until position b.
 	 * It is assumed, that the vector is sorted up to position a.
 	 */
-	void presort_(size_t a, size_t b)
+	void presort_(std::vector<size_t>& indices, std::vector<size_t>& tmp,
+	              size_t a, size_t b)
 	{
 		// Sort [a, b)
-		std::sort(indices_.begin() + a, indices_.begin() + b);
+		std::sort(indices.begin() + a, indices.begin() + b);
 
 		// Merge [0, a) and [a, b) into a temporary vector.
 		// Note that inplace_merge would reallocate a new vector
 		// every time it is called.
-		std::merge(indices_.begin(), indices_.begin() + a, indices_.begin() + a,
-		           indices_.begin() + b, tmp_indices_.begin());
+		std::merge(indices.begin(), indices.begin() + a, indices.begin() + a,
+		           indices.begin() + b, tmp.begin());
 
 		// Copy the sorted range [0, b) from the temporary vector
 		// to the names_ vector
-		std::copy(tmp_indices_.begin(), tmp_indices_.begin() + b,
-		          indices_.begin());
+		std::copy(tmp.begin(), tmp.begin() + b, indices.begin());
 	}
 
-	Category category_;
 	size_t permutations_;
-	std::mt19937_64 twister_;
-	std::vector<size_t> indices_;
-	std::vector<size_t> tmp_indices_;
+	const NullDistributionCache* cache_ = nullptr;
+	NullDistributionKey key_;
+	std::vector<Worker> workers_;
 };
 
+template <typename value_type>
+constexpr size_t RowPermutationTest<value_type>::blockSize_;
+
 template <typename value_type>
 class ColumnPermutationBase : public internal::PermutationBase<value_type>
 {
   public:
 	ColumnPermutationBase(const DenseMatrix& data, size_t permutations,
 	                      size_t reference_size, MatrixHTests method,
-	                      uint64_t randomSeed, const EntityDatabase* db)
+	                      uint64_t randomSeed, const EntityDatabase* db,
+	                      size_t numThreads = 1)
 	    : permutations_(permutations),
 	      data_(data),
 	      reference_size_(reference_size),
 	      method_(method),
-	      twister_(randomSeed),
+	      randomSeed_(randomSeed),
+	      numThreads_(std::max<size_t>(1, std::min(numThreads, permutations))),
 	      db_(db)
 	{
 	}
 
 	void initScoring_()
 	{
-		std::vector<size_t> row_db_indices(data_.rows());
+		row_db_indices_.resize(data_.rows());
 
 		db_->transform(data_.rowNames().begin(), data_.rowNames().end(),
-		               row_db_indices.begin());
+		               row_db_indices_.begin());
 
 		// We need to make sure, that the EntityDatabase indices of
 		// the data are sorted in strictly ascending order, as we
 		// exploit this property later to find the genes belonging to a
 		// category.
-		assert(rowIndicesStrictlySorted_(row_db_indices));
-
-		scoring.setRowDBIndices(row_db_indices);
+		assert(rowIndicesStrictlySorted_(row_db_indices_));
 	}
 
   protected:
+	/**
+	 * The state that is needed by a single thread for performing its
+	 * share of the column permutations. Every worker owns a copy of the
+	 * enrichment algorithm, as setting the permuted scores modifies it.
+	 */
+	struct Worker
+	{
+		Worker(size_t cols, uint64_t seed, EnrichmentAlgorithmPtr algorithm)
+		    : twister(seed),
+		      algorithm(std::move(algorithm)),
+		      column_indices(cols)
+		{
+			std::iota(column_indices.begin(), column_indices.end(),
+			          static_cast<size_t>(0));
+		}
+
+		std::mt19937 twister;
+		EnrichmentAlgorithmPtr algorithm;
+
+		MatrixHTest scoring;
+		std::vector<size_t> column_indices;
+		std::vector<size_t> permutation;
+		std::vector<size_t> inv_permutation;
+		std::vector<size_t> intersection;
+		std::vector<size_t> counter;
+	};
+
 	bool rowIndicesStrictlySorted_(const std::vector<size_t>& data)
 	{
 		Matrix::index_type i = 0;
@@ -274,90 +714,202 @@ class ColumnPermutationBase : public internal::PermutationBase<value_type>
 		return true;
 	};
 
-	Scores computeScores_(std::vector<size_t>::iterator begin,
-	                      std::vector<size_t>::iterator end)
+	/**
+	 * Creates the workers. Every worker gets its own copy of the
+	 * algorithm.
+	 */
+	std::vector<Worker> setupWorkers_(const EnrichmentAlgorithmPtr& algorithm,
+	                                  size_t numTests)
+	{
+		std::vector<Worker> workers;
+		workers.reserve(numThreads_);
+
+		for(size_t t = 0; t < numThreads_; ++t) {
+			workers.emplace_back(data_.cols(),
+			                     this->workerSeed_(randomSeed_, t),
+			                     algorithm->clone());
+			workers.back().scoring.setRowDBIndices(row_db_indices_);
+			workers.back().counter.resize(numTests);
+		}
+
+		return workers;
+	}
+
+	/**
+	 * Calls f(worker, j) for all permutations j in [first, first + count)
+	 * in parallel. Every worker is assigned a contiguous block of the
+	 * permutations.
+	 */
+	template <typename Function>
+	void runPermutations_(std::vector<Worker>& workers, size_t first,
+	                      size_t count, Function f)
+	{
+		const auto numThreads = workers.size();
+
+		internal::runWorkers(numThreads, [&](size_t t) {
+			auto offset = first;
+			for(size_t u = 0; u < t; ++u) {
+				offset += this->workerPermutations_(count, numThreads, u);
+			}
+
+			auto n = this->workerPermutations_(count, numThreads, t);
+			for(size_t i = 0; i < n; ++i) {
+				// Only the first worker reports its progress, as
+				// the output of multiple threads would be garbled.
+				if(t == 0) {
+					this->printStatus_(first + i, permutations_);
+				}
+
+				f(workers[t], offset + i);
+			}
+		});
+	}
+
+	Scores computeScores_(Worker& worker)
 	{
-		std::shuffle(begin, end, twister_);
+		auto begin = worker.column_indices.begin();
+		auto end = worker.column_indices.end();
+
+		std::shuffle(begin, end, worker.twister);
 
 		auto mid = begin + reference_size_;
 
 		auto ref = DenseColumnSubset(&data_, begin, mid);
 		auto sam = DenseColumnSubset(&data_, mid, end);
 
-		return Scores(scoring.test(method_, ref, sam));
+		return Scores(worker.scoring.test(method_, ref, sam));
 	}
 
-	void setupPositons_(const Scores& scores, const EnrichmentResults& tests)
+	/**
+	 * Computes the positions of the category members in the list of
+	 * scores sorted by index. As the rows of the matrix are sorted by
+	 * their database index, these positions are the same for every
+	 * permutation and are shared by all workers.
+	 */
+	void setupPositons_(const EnrichmentResults& tests)
 	{
 		positions_.resize(tests.size());
 
 		for(size_t i = 0; i < tests.size(); ++i) {
-			positions_[i] = scores.subsetIndices(*tests[i]->category);
+			const auto& category = *tests[i]->category;
+
+			positions_[i].clear();
+			for(size_t r = 0; r < row_db_indices_.size(); ++r) {
+				if(category.contains(row_db_indices_[r])) {
+					positions_[i].emplace_back(r);
+				}
+			}
 		}
 	}
 
-	Scores updateLookupTables_(const EnrichmentResults& tests, Scores& scores,
-	                           Order order)
+	void updateLookupTables_(Worker& worker, Scores& scores, Order order)
 	{
 		// We first need to sort the scores by index, as we know the
 		// position of the category genes in the sorted list.
 		scores.sortByIndex();
 
-		// If we do not yet know the positions compute them.
-		// We can only do this here as we do not have the scores
-		// available earlier.
-		if(positions_.empty()) {
-			setupPositons_(scores, tests);
-		}
-
 		// We now obtain the permution of the genes that is used
-		// for sorting the scores by value.
+		// for sorting the scores by value. This must match the order
+		// established by Scores::sortByScore.
 		switch(order) {
-			case Order::Decreasing:
-				sort_permutation(permutation_, scores.scores().begin(),
-				                 scores.scores().end(), std::less<double>());
 			case Order::Increasing:
-				sort_permutation(permutation_, scores.scores().begin(),
+				sort_permutation(worker.permutation, scores.scores().begin(),
+				                 scores.scores().end(), std::less<double>());
+				break;
+			case Order::Decreasing:
+				sort_permutation(worker.permutation, scores.scores().begin(),
 				                 scores.scores().end(), std::greater<double>());
+				break;
 		}
 
 		// After that we invert the permutation so that we
 		// can use it as a lookup table to get the new position.
-		invert_permutation(permutation_, inv_permutation_);
-
-		return scores;
+		invert_permutation(worker.permutation, worker.inv_permutation);
 	}
 
-	double computeEnrichmentScore_(const EnrichmentAlgorithmPtr& algorithm,
-	                               const EnrichmentResults& tests, size_t i)
+	double computeEnrichmentScore_(Worker& worker, size_t i)
 	{
 		// Setup the vector that will hold the positions of the category
 		// genes in the new score vector.
-		intersection_.resize(tests[i]->hits);
+		auto& intersection = worker.intersection;
+		intersection.resize(positions_[i].size());
 
 		// Fill the intersection vector using the inverse permutation
-		std::transform(positions_[i].begin(), positions_[i].end(),
-		               intersection_.begin(),
-		               [&](size_t entry) { return inv_permutation_[entry]; });
+		std::transform(
+		    positions_[i].begin(), positions_[i].end(), intersection.begin(),
+		    [&worker](size_t entry) { return worker.inv_permutation[entry]; });
 
-		// Sort the intersection_ vector
-		std::sort(intersection_.begin(), intersection_.end());
+		// Sort the intersection vector
+		std::sort(intersection.begin(), intersection.end());
 
 		// Compute the enrichment score for this permutation
-		return std::get<0>(algorithm->computeEnrichmentScore(
-		    intersection_.begin(), intersection_.end()));
+		return std::get<0>(worker.algorithm->computeEnrichmentScore(
+		    intersection.cbegin(), intersection.cend()));
+	}
+
+	/**
+	 * Computes the score of every test i for which active(i) holds for a
+	 * single permutation and passes it to the callback store(i, score).
+	 */
+	template <typename Active, typename Store>
+	void performSinglePermutation_(Worker& worker,
+	                               const EnrichmentResults& tests,
+	                               Active active, Store store)
+	{
+		// Create a new permutation and compute new scores.
+		Scores scores = computeScores_(worker);
+
+		if(!worker.algorithm->supportsIndices()) {
+			worker.algorithm->setScores(scores);
+
+			for(size_t i = 0; i < tests.size(); ++i) {
+				if(active(i)) {
+					store(i,
+					      std::get<0>(worker.algorithm->computeEnrichmentScore(
+					          *tests[i]->category)));
+				}
+			}
+
+			return;
+		}
+
+		// Update all the required lookup tables needed for finding
+		// category members quickly.
+		updateLookupTables_(worker, scores, worker.algorithm->getOrder());
+
+		// Now pass the scores to the algorithm
+		worker.algorithm->setScores(scores);
+
+		for(size_t i = 0; i < tests.size(); ++i) {
+			if(active(i)) {
+				store(i, computeEnrichmentScore_(worker, i));
+			}
+		}
+	}
+
+	/**
+	 * Prepares the data structures that are shared read-only by all
+	 * workers.
+	 */
+	void setupSharedState_(const EnrichmentAlgorithmPtr& algorithm,
+	                       const EnrichmentResults& tests)
+	{
+		initScoring_();
+
+		positions_.clear();
+		if(algorithm->supportsIndices()) {
+			setupPositons_(tests);
+		}
 	}
 
 	size_t permutations_;
 	DenseMatrix data_;
 	size_t reference_size_;
 	MatrixHTests method_;
-	std::mt19937 twister_;
+	uint64_t randomSeed_;
+	size_t numThreads_;
 
-	MatrixHTest scoring;
-	std::vector<size_t> permutation_;
-	std::vector<size_t> inv_permutation_;
-	std::vector<size_t> intersection_;
+	std::vector<size_t> row_db_indices_;
 	std::vector<std::vector<size_t>> positions_;
 	const EntityDatabase* db_;
 };
@@ -368,78 +920,38 @@ class ColumnPermutationTest : public ColumnPermutationBase<value_type>
   public:
 	ColumnPermutationTest(const DenseMatrix& data, size_t permutations,
 	                      size_t reference_size, MatrixHTests method,
-	                      uint64_t randomSeed, const EntityDatabase* db)
+	                      uint64_t randomSeed, const EntityDatabase* db,
+	                      size_t numThreads = 1)
 	    : ColumnPermutationBase<value_type>(data, permutations, reference_size,
-	                                        method, randomSeed, db)
+	                                        method, randomSeed, db, numThreads)
 	{
 	}
 
 	void computePValue(const EnrichmentAlgorithmPtr& algorithm,
 	                   EnrichmentResults& tests)
 	{
-		this->positions_.clear();
-
-		this->initScoring_();
-
-		std::vector<size_t> counter(tests.size());
-		std::vector<size_t> column_indices(this->data_.cols());
-		std::iota(column_indices.begin(), column_indices.end(),
-		          static_cast<size_t>(0));
-
-		for(size_t i = 0; i < this->permutations_; ++i) {
-			this->printStatus_(i, this->permutations_);
-
-			if(algorithm->supportsIndices()) {
-				performSinglePermutationIndices_(algorithm, tests, counter,
-				                                 column_indices);
-			} else {
-				performSinglePermutation_(algorithm, tests, counter,
-				                          column_indices);
-			}
-		}
-
-		this->updatePValues_(tests, counter, this->permutations_);
-	}
-
-	void performSinglePermutation_(const EnrichmentAlgorithmPtr& algorithm,
-	                               const EnrichmentResults& tests,
-	                               std::vector<size_t>& counter,
-	                               std::vector<size_t>& column_indices)
-	{
-		Scores scores =
-		    this->computeScores_(column_indices.begin(), column_indices.end());
-
-		algorithm->setScores(scores);
-
-		for(size_t i = 0; i < tests.size(); ++i) {
-			auto score = std::get<0>(
-			    algorithm->computeEnrichmentScore(*tests[i]->category));
-
-			this->updateCounter_(tests[i], counter[i], score);
-		}
-	}
-
-	void performSinglePermutationIndices_(
-	    const EnrichmentAlgorithmPtr& algorithm, const EnrichmentResults& tests,
-	    std::vector<size_t>& counter, std::vector<size_t>& column_indices)
-	{
-		// Create a new permutation and compute new scores.
-		Scores scores =
-		    this->computeScores_(column_indices.begin(), column_indices.end());
-
-		// Update all the required lookup tables needed for finding
-		// category members quickly.
-		this->updateLookupTables_(tests, scores, algorithm->getOrder());
-
-		// Now pass the scores to the algorithm
-		algorithm->setScores(scores);
-
-		for(size_t i = 0; i < tests.size(); ++i) {
-			auto score = this->computeEnrichmentScore_(algorithm, tests, i);
-
-			// Update the counter with the newly computed value
-			this->updateCounter_(tests[i], counter[i], score);
-		}
+		this->setupSharedState_(algorithm, tests);
+
+		auto workers = this->setupWorkers_(algorithm, tests.size());
+
+		using Worker = typename ColumnPermutationBase<value_type>::Worker;
+		auto active = [this](size_t i) { return this->active_[i] != 0; };
+		auto permute = [this, &tests, &active](Worker& worker, size_t) {
+			this->performSinglePermutation_(
+			    worker, tests, active,
+			    [&worker, &tests, this](size_t i, double score) {
+				    this->updateCounter_(tests[i], worker.counter[i], score);
+				});
+		};
+
+		this->runAdaptive_(
+		    tests, this->permutations_,
+		    [this, &workers, &permute](size_t first, size_t count) {
+			    this->runPermutations_(workers, first, count, permute);
+			},
+		    [this, &workers](std::vector<size_t>& counter) {
+			    this->reduceCounters_(workers, counter);
+			});
 	}
 };
 
@@ -449,34 +961,40 @@ class KSColumnPermutationTest : public ColumnPermutationBase<value_type>
   public:
 	KSColumnPermutationTest(const DenseMatrix& data, size_t permutations,
 	                        size_t reference_size, MatrixHTests method,
-	                        uint64_t randomSeed, const EntityDatabase* db)
+	                        uint64_t randomSeed, const EntityDatabase* db,
+	                        size_t numThreads = 1)
 	    : ColumnPermutationBase<value_type>(data, permutations, reference_size,
-	                                        method, randomSeed, db)
+	                                        method, randomSeed, db, numThreads)
 	{
 	}
 
 	void computePValue(const EnrichmentAlgorithmPtr& algorithm,
 	                   EnrichmentResults& tests)
 	{
-		this->positions_.clear();
+		this->setupSharedState_(algorithm, tests);
 
-		this->initScoring_();
+		auto workers = this->setupWorkers_(algorithm, tests.size());
 
+		// Every worker writes the scores of its permutations j into the
+		// disjoint slots permuted_values[i * permutations_ + j].
 		std::vector<double> permuted_values(tests.size() * this->permutations_);
-		std::vector<size_t> column_indices(this->data_.cols());
-		std::iota(column_indices.begin(), column_indices.end(),
-		          static_cast<size_t>(0));
-
-		for(size_t i = 0; i < this->permutations_; ++i) {
-			this->printStatus_(i, this->permutations_);
 
-			if(algorithm->supportsIndices()) {
-				performSinglePermutationIndices_(
-				    i, algorithm, tests, permuted_values, column_indices);
-			} else {
-				performSinglePermutation_(i, algorithm, tests, permuted_values,
-				                          column_indices);
-			}
+		using Worker = typename ColumnPermutationBase<value_type>::Worker;
+		this->runPermutations_(
+		    workers, 0, this->permutations_,
+		    [this, &tests, &permuted_values](Worker& worker, size_t j) {
+			    this->performSinglePermutation_(
+			        worker, tests, [](size_t) { return true; },
+			        [this, j, &permuted_values](size_t i, double score) {
+				        permuted_values[i * this->permutations_ + j] = score;
+				    });
+			});
+
+		// The normalisation of the scores requires the full null
+		// distribution of every category, so early stopping is not
+		// supported here.
+		for(auto& test : tests) {
+			test->permutations = this->permutations_;
 		}
 
 		updatePValues_(tests, permuted_values);
@@ -592,47 +1110,6 @@ class KSColumnPermutationTest : public ColumnPermutationBase<value_type>
 		}
 	}
 
-	void performSinglePermutation_(size_t j,
-	                               const EnrichmentAlgorithmPtr& algorithm,
-	                               const EnrichmentResults& tests,
-	                               std::vector<double>& permuted_values,
-	                               std::vector<size_t>& column_indices)
-	{
-		Scores scores =
-		    this->computeScores_(column_indices.begin(), column_indices.end());
-
-		algorithm->setScores(scores);
-
-		for(size_t i = 0; i < tests.size(); ++i) {
-			auto score = std::get<0>(
-			    algorithm->computeEnrichmentScore(*tests[i]->category));
-
-			permuted_values[i * this->permutations_ + j] = score;
-		}
-	}
-
-	void performSinglePermutationIndices_(
-	    size_t j, const EnrichmentAlgorithmPtr& algorithm,
-	    const EnrichmentResults& tests, std::vector<double>& permuted_values,
-	    std::vector<size_t>& column_indices)
-	{
-		// Compute scores for a new permutation
-		Scores scores =
-		    this->computeScores_(column_indices.begin(), column_indices.end());
-
-		// Update all the required lookup tables needed for finding
-		// category members quickly.
-		this->updateLookupTables_(tests, scores, algorithm->getOrder());
-
-		// Now pass the scores to the algorithm
-		algorithm->setScores(scores);
-
-		for(size_t i = 0; i < tests.size(); ++i) {
-			auto score = this->computeEnrichmentScore_(algorithm, tests, i);
-
-			permuted_values[i * this->permutations_ + j] = score;
-		}
-	}
 };
 }
 
@@ -24,17 +24,27 @@
 #include "EnrichmentResult.h"
 
 #include <genetrail2/core/HTest.h>
+#include <genetrail2/core/IndependentTTest.h>
 #include <genetrail2/core/Scores.h>
 #include <genetrail2/core/GeneSetEnrichmentAnalysis.h>
+#include <genetrail2/core/KolmogorovSmirnovPValueCache.h>
 #include <genetrail2/core/WeightedGeneSetEnrichmentAnalysis.h>
 #include <genetrail2/core/OverRepresentationAnalysis.h>
 #include <genetrail2/core/OneSampleTTest.h>
 #include <genetrail2/core/WilcoxonRankSumTest.h>
 #include <genetrail2/core/misc_algorithms.h>
+#include <genetrail2/core/Workers.h>
 
 #include <boost/iterator/filter_iterator.hpp>
 #include <boost/iterator/transform_iterator.hpp>
 
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <type_traits>
+
 namespace GeneTrail
 {
 	class Category;
@@ -51,6 +61,11 @@ namespace GeneTrail
 		struct Indirect
 		{
 		};
+		/// Like Direct, but the p-values of all categories are computed
+		/// together after scoring.
+		struct Batched
+		{
+		};
 		struct Scores
 		{
 		};
@@ -174,16 +189,40 @@ namespace GeneTrail
 		Scores scores_;
 	};
 
+	namespace internal
+	{
+		/**
+		 * True for two-sample tests that only depend on the means, the
+		 * variances and the sizes of both groups. These are scored from
+		 * the sufficient statistics of the category and of all scores.
+		 */
+		template <typename Test>
+		struct UsesSufficientStatistics : public std::false_type
+		{
+		};
+
+		template <typename T>
+		struct UsesSufficientStatistics<IndependentTTest<T>>
+		    : public std::true_type
+		{
+		};
+	}
+
 	template <typename Test>
 	class HTestEnrichment : public HTestEnrichmentBase<Test>
 	{
 		public:
-		using HTestEnrichmentBase<Test>::HTestEnrichmentBase;
+		HTestEnrichment(const Scores& scores) : HTestEnrichmentBase<Test>(scores)
+		{
+			updateSufficientStatistics_();
+		}
 
 		void setInputScores(const Scores& scores)
 		{
 			this->scores_ = scores;
 			this->scores_.sortByIndex();
+
+			updateSufficientStatistics_();
 		}
 
 		bool canUseCategory(const Category&, size_t hits) const
@@ -198,6 +237,60 @@ namespace GeneTrail
 		}
 
 		std::tuple<double, double> computeScore(const Category& c)
+		{
+			auto score = computeScore_(
+			    c, internal::UsesSufficientStatistics<Test>());
+
+			return std::make_tuple(score, 0.0);
+		}
+
+		private:
+		/**
+		 * Scores the category against its complement from the sufficient
+		 * statistics. The moments of the complement are obtained by
+		 * removing the moments of the category from the global moments,
+		 * so only the members of the category are visited.
+		 */
+		double computeScore_(const Category& c, std::true_type)
+		{
+			double mean = 0.0;
+			double m2 = 0.0;
+			size_t size = 0;
+			for(size_t id : c) {
+				if(id >= entity_scores_.size() ||
+				   std::isnan(entity_scores_[id])) {
+					continue;
+				}
+
+				const double x = entity_scores_[id];
+				++size;
+				const double delta = x - mean;
+				mean += delta / size;
+				m2 += delta * (x - mean);
+			}
+
+			const size_t total = this->scores_.size();
+			const size_t size_c = total - size;
+			// A category covering all scores has an empty complement, whose
+			// mean is zero like in the fallback.
+			const double mean_c =
+			    size_c == 0 ? 0.0
+			                : (total * total_mean_ - size * mean) / size_c;
+			const double delta = mean - mean_c;
+			const double m2_c =
+			    std::max(0.0, total_m2_ - m2 -
+			                      delta * delta * size * size_c / total);
+
+			const double var = size <= 1 ? 0.0 : m2 / (size - 1);
+			const double var_c = size_c <= 1 ? 0.0 : m2_c / (size_c - 1);
+
+			return test_.test(mean, var, size, mean_c, var_c, size_c);
+		}
+
+		/**
+		 * Fallback for tests that need the values of the complement.
+		 */
+		double computeScore_(const Category& c, std::false_type)
 		{
 			using namespace boost;
 
@@ -215,83 +308,170 @@ namespace GeneTrail
 			auto jt_beg = make_transform_iterator(jt_tmp_beg, project_to_score);
 			auto jt_end = make_transform_iterator(jt_tmp_end, project_to_score);
 
-			auto score = HTest::test(test_, which.scores().begin(), which.scores().end(), jt_beg, jt_end);
+			return HTest::test(test_, which.scores().begin(),
+			                   which.scores().end(), jt_beg, jt_end);
+		}
 
-			return std::make_tuple(score, 0.0);
+		void updateSufficientStatistics_()
+		{
+			if(!internal::UsesSufficientStatistics<Test>::value) {
+				return;
+			}
+
+			const auto& scores = this->scores_;
+			const size_t n = scores.size();
+
+			// The scores are sorted by index, so the last entity has the
+			// largest index. Entities without a score are marked by NaN.
+			entity_scores_.assign(n == 0 ? 0 : scores[n - 1].index() + 1,
+			                      std::numeric_limits<double>::quiet_NaN());
+
+			total_mean_ = 0.0;
+			total_m2_ = 0.0;
+			for(size_t i = 0; i < n; ++i) {
+				const double x = scores[i].score();
+				entity_scores_[scores[i].index()] = x;
+
+				const double delta = x - total_mean_;
+				total_mean_ += delta / (i + 1);
+				total_m2_ += delta * (x - total_mean_);
+			}
 		}
 
-		private:
 		Test test_;
+
+		/// The score of every entity, indexed by its id.
+		std::vector<double> entity_scores_;
+		/// The mean and the sum of squared deviations of all scores.
+		double total_mean_ = 0.0;
+		double total_m2_ = 0.0;
 	};
 
-    template <typename T>
-    class HTestEnrichment<WilcoxonRankSumTest<T>>
-        : public HTestEnrichmentBase<WilcoxonRankSumTest<T>>
-    {
-	  public:
+	/**
+	 * The global ranks of the scores do not change while the categories
+	 * are scored. The tie-averaged rank of every entity is thus computed
+	 * once in setInputScores and the rank sum of a category is obtained by
+	 * summing the ranks of its members.
+	 */
+	template <typename T>
+	class HTestEnrichment<WilcoxonRankSumTest<T>>
+	    : public HTestEnrichmentBase<WilcoxonRankSumTest<T>>
+	{
+		public:
 		using Base = HTestEnrichmentBase<WilcoxonRankSumTest<T>>;
+		using SupportsIndices = StatTags::SupportsIndices;
 
-		HTestEnrichment(const Scores& scores)
-			: Base(scores),
-			  sorted_scores_(scores)
+		HTestEnrichment(const Scores& scores) : Base(scores)
 		{
-			updateSortedScores_();
+			updateRanks_();
 		}
 
-	    void setInputScores(const Scores& scores)
-	    {
-		    this->scores_ = scores;
-		    this->scores_.sortByIndex();
-		    this->sorted_scores_ = scores;
+		/**
+		 * The indices passed to computeScore refer to the positions of
+		 * the scores sorted in this order.
+		 */
+		Order getOrder() const { return Order::Decreasing; }
 
-			updateSortedScores_();
-	    }
+		void setInputScores(const Scores& scores)
+		{
+			this->scores_ = scores;
+			this->scores_.sortByIndex();
 
-	    bool canUseCategory(const Category&, size_t hits) const
-	    {
-		    return hits > 1;
-	    }
+			updateRanks_();
+		}
 
-	    double computeRowWisePValue(EnrichmentResult* result)
-	    {
-		    return Base::computeRowWisePValue(test_, result);
-	    }
+		bool canUseCategory(const Category&, size_t hits) const
+		{
+			return hits > 1;
+		}
 
-	    std::tuple<double, double> computeScore(const Category& c)
-	    {
-		    using namespace boost;
+		double computeRowWisePValue(EnrichmentResult* result)
+		{
+			return Base::computeRowWisePValue(test_, result);
+		}
 
-		    auto which = this->scores_.subset(c);
-			which.sortByScore(Order::Increasing);
+		std::tuple<double, double> computeScore(const Category& c)
+		{
+			T rank_sum = 0;
+			size_t hits = 0;
+			for(size_t id : c) {
+				if(id < entity_ranks_.size() && !std::isnan(entity_ranks_[id])) {
+					rank_sum += entity_ranks_[id];
+					++hits;
+				}
+			}
 
-		    auto score = test_.test_sorted(sorted_scores_, which.begin(), which.end());
+			return std::make_tuple(rankSumScore_(rank_sum, hits), 0.0);
+		}
 
-		    return std::make_tuple(score, 0.0);
-	    }
+		std::tuple<double, double> computeScore(IndexIterator begin,
+		                                        IndexIterator end)
+		{
+			return std::make_tuple(rankSumScore_(begin, end), 0.0);
+		}
 
-	  private:
-		void updateSortedScores_()
+		void computeScores(const std::vector<IndexIterator>& begins,
+		                   size_t length, std::vector<double>& scores)
 		{
-		    score_permutation_.resize(this->scores_.size());
-		    std::iota(score_permutation_.begin(), score_permutation_.end(),
-		              static_cast<size_t>(0));
+			scores.resize(begins.size());
+			for(size_t b = 0; b < begins.size(); ++b) {
+				scores[b] = rankSumScore_(begins[b], begins[b] + length);
+			}
+		}
+
+		private:
+		void updateRanks_()
+		{
+			const auto& scores = this->scores_;
+			const size_t n = scores.size();
+
+			values_.assign(scores.scores().begin(), scores.scores().end());
+			position_ranks_.resize(n);
+			statistic::ranks(values_.begin(), values_.end(),
+			                 position_ranks_.begin(), order_);
+
+			// The scores are sorted by index, so the last entity has the
+			// largest index. Entities without a score are marked by NaN.
+			entity_ranks_.assign(n == 0 ? 0 : scores[n - 1].index() + 1,
+			                     std::numeric_limits<T>::quiet_NaN());
+			for(size_t i = 0; i < n; ++i) {
+				entity_ranks_[scores[i].index()] = position_ranks_[i];
+			}
+
+			// As the ranks are monotonic in the scores, sorting them in
+			// decreasing order yields the rank of every position in the
+			// scores sorted by getOrder().
+			std::sort(position_ranks_.begin(), position_ranks_.end(),
+			          std::greater<T>());
+		}
 
-		    auto comp = [this](size_t i, size_t j) {
-				return Scores::LessScore()(this->scores_[i], this->scores_[j]);
-			};
+		T rankSumScore_(IndexIterator begin, IndexIterator end)
+		{
+			T rank_sum = 0;
+			for(auto it = begin; it != end; ++it) {
+				rank_sum += position_ranks_[*it];
+			}
 
-		    score_permutation_ = sort_permutation(
-		        score_permutation_.begin(), score_permutation_.end(), comp);
+			return rankSumScore_(rank_sum, std::distance(begin, end));
+		}
 
-		    for(size_t i = 0; i < sorted_scores_.size(); ++i) {
-			    sorted_scores_.set(i, this->scores_[score_permutation_[i]]);
-		    }
+		T rankSumScore_(T rank_sum, size_t hits)
+		{
+			return test_.computeZScore(rank_sum, hits,
+			                           this->scores_.size() - hits);
 		}
 
-	    WilcoxonRankSumTest<T> test_;
-	    Scores sorted_scores_;
-	    std::vector<size_t> score_permutation_;
-    };
+		WilcoxonRankSumTest<T> test_;
+
+		/// The rank of every entity, indexed by its id.
+		std::vector<T> entity_ranks_;
+		/// The ranks of the scores sorted by getOrder().
+		std::vector<T> position_ranks_;
+
+		// Scratch space of updateRanks_.
+		std::vector<T> values_;
+		std::vector<size_t> order_;
+	};
 
 	template <typename T>
 	class HTestEnrichment<OneSampleTTest<T>>
@@ -368,12 +548,22 @@ namespace GeneTrail
 		OverRepresentationAnalysis test_;
 	};
 
-	class KolmogorovSmirnov : public SetLevelStatistics<StatTags::Direct, StatTags::SupportsIndices>
+	class KolmogorovSmirnov : public SetLevelStatistics<StatTags::Batched, StatTags::SupportsIndices>
 	{
 		public:
+		using PValueCache = KolmogorovSmirnovPValueCache;
+
+		/**
+		 * @param cache The cache used for the exact p-values. Copies of
+		 *              this object share the cache. Passing a cache
+		 *              allows to keep the p-values across runs.
+		 */
 		template <typename Iterator>
-		KolmogorovSmirnov(const Iterator& beginIds, const Iterator& endIds, Order order)
-		    : order_(order), ids_(beginIds, endIds)
+		KolmogorovSmirnov(const Iterator& beginIds, const Iterator& endIds,
+		                  Order order,
+		                  std::shared_ptr<PValueCache> cache =
+		                      std::make_shared<PValueCache>())
+		    : order_(order), ids_(beginIds, endIds), cache_(std::move(cache))
 		{
 		}
 
@@ -403,26 +593,88 @@ namespace GeneTrail
 			return std::make_tuple(score, 0.0);
 		}
 
+		void computeScores(const std::vector<IndexIterator>& begins,
+		                   size_t length, std::vector<double>& scores)
+		{
+			scores.resize(begins.size());
+			test_.computeRunningSums(ids_.size(), begins, length,
+			                         scores.begin(), buffers_);
+		}
+
+		/// Requires the hits of result to be set.
 		double computeRowWisePValue(EnrichmentResult* result)
 		{
-			auto intersection_size = test_.intersectionSize(
-			    *result->category, ids_.begin(), ids_.end());
+			return cache_->pValue(ids_.size(), result->hits,
+			                      static_cast<int64_t>(result->score),
+			                      side_(result->score));
+		}
+
+		/**
+		 * Computes the p-values of all results. The p-value of a category
+		 * only depends on its number of hits and its running sum, so the
+		 * results are grouped by the number of hits and the p-values of
+		 * every group are computed in batches. The hits of all results
+		 * must have been set.
+		 */
+		void computeRowWisePValues(const EnrichmentResults& results,
+		                           size_t numThreads)
+		{
+			using Group = std::pair<size_t, PValueCache::Side>;
 
-			if(result->score > 0.0) {
-				return test_.computeRightPValue(ids_.size(), intersection_size,
-				                                result->score)
-				    .convert_to<double>();
-			} else {
-				return test_.computeLeftPValue(ids_.size(), intersection_size,
-				                               result->score)
-				    .convert_to<double>();
+			std::map<Group, std::vector<int64_t>> groups;
+			for(size_t i = 0; i < results.size(); ++i) {
+				const double score = results[i]->score;
+				groups[Group(results[i]->hits, side_(score))].push_back(
+				    static_cast<int64_t>(score));
+			}
+
+			std::vector<decltype(groups)::const_iterator> group_list;
+			for(auto it = groups.cbegin(); it != groups.cend(); ++it) {
+				group_list.push_back(it);
+			}
+
+			forEachParallel_(group_list.size(), numThreads, [&](size_t i) {
+				const auto& group = *group_list[i];
+				cache_->precompute(ids_.size(), group.first.first,
+				                   group.second, group.first.second);
+			});
+
+			for(size_t i = 0; i < results.size(); ++i) {
+				const double score = results[i]->score;
+				results[i]->pvalue =
+				    cache_->pValue(ids_.size(), results[i]->hits,
+				                   static_cast<int64_t>(score), side_(score));
 			}
 		}
 
 		private:
+		static PValueCache::Side side_(double score)
+		{
+			return score > 0.0 ? PValueCache::Side::Right
+			                   : PValueCache::Side::Left;
+		}
+
+		template <typename Function>
+		static void forEachParallel_(size_t n, size_t numThreads, Function f)
+		{
+			std::atomic<size_t> next(0);
+			internal::runWorkers(
+			    std::max<size_t>(1, std::min(numThreads, n)), [&](size_t) {
+				    for(size_t i = next++; i < n; i = next++) {
+					    f(i);
+				    }
+				});
+		}
+
 		Order order_;
 		std::vector<size_t> ids_;
 		GeneSetEnrichmentAnalysis<big_float, int64_t> test_;
+		std::shared_ptr<PValueCache> cache_;
+
+		// Scratch memory of computeScores. Every worker of a permutation
+		// test scores with its own clone, so this is never shared.
+		GeneSetEnrichmentAnalysis<big_float, int64_t>::RunningSumBuffers
+		    buffers_;
 	};
 
 	class WeightedKolmogorovSmirnov
@@ -459,6 +711,16 @@ namespace GeneTrail
 			return std::make_tuple(score, 0.0);
 		}
 
+		void computeScores(const std::vector<IndexIterator>& begins,
+		                   size_t length, std::vector<double>& scores)
+		{
+			scores.resize(begins.size());
+			for(size_t b = 0; b < begins.size(); ++b) {
+				scores[b] =
+				    test_.computeRunningSum(begins[b], begins[b] + length);
+			}
+		}
+
 		private:
 		Order order_;
 		WeightedGeneSetEnrichmentAnalysis<double> test_;
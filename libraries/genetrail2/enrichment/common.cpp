@@ -22,6 +22,7 @@
 
 #include "EnrichmentAlgorithm.h"
 #include "EnrichmentResult.h"
+#include "NullDistributionCache.h"
 #include "Parameters.h"
 #include "PermutationTest.h"
 
@@ -31,11 +32,16 @@
 #include <genetrail2/core/GMTFile.h>
 #include <genetrail2/core/PValue.h>
 #include <genetrail2/core/TextFile.h>
+#include <genetrail2/core/Workers.h>
 
 #include <boost/filesystem.hpp>
 
 #include <algorithm>
+#include <atomic>
 #include <fstream>
+#include <iterator>
+#include <mutex>
+#include <thread>
 
 static CategoryList getCategoryList(const std::string& catfile_list)
 {
@@ -76,69 +82,117 @@ static void readTestSet(GeneSet& test_set, const Params& p)
 	}
 }
 
-static PValueList resultVector(const Results& results)
+static PValueList resultVector(const ResultTable& table, size_t begin, size_t end)
 {
 	PValueList result;
-	result.reserve(results.size());
-	for(const auto& jt : results) {
-		result.push_back(
-		    std::make_pair(jt.first, jt.second->pvalue.convert_to<double>()));
+	result.reserve(end - begin);
+	for(size_t i = begin; i < end; ++i) {
+		result.emplace_back(i, table.results[i]->pvalue.convert_to<double>());
 	}
 	return result;
 }
 
-static PValueList resultVector(const AllResults& results)
+/**
+ * Returns the sorted entity ids of the scores that are members of c.
+ * The category is already sorted by id, so it suffices to keep the
+ * members that are contained in the test set. Lookups in test_set are
+ * binary searches as run() sorts it by index.
+ */
+static std::vector<size_t> hitIds(const Category& c, const Scores& test_set)
 {
-	PValueList result;
-	result.reserve(results.size());
-	for(const auto& it : results) {
-		for(const auto& jt : it.second) {
-			result.push_back(
-			    std::make_pair(it.first + "\t" + jt.first,
-			                   jt.second->pvalue.convert_to<double>()));
+	std::vector<size_t> ids;
+	ids.reserve(std::min(c.size(), test_set.size()));
+
+	for(auto id : c) {
+		if(test_set.contains(Score(id, 0.0))) {
+			ids.emplace_back(id);
 		}
 	}
-	return result;
+
+	return ids;
 }
 
-static std::tuple<bool, size_t, std::string>
-processCategory(const Category& c, const Scores& test_set, const Params& p)
+/**
+ * Computes the enrichment of all categories of a database. The categories
+ * are distributed dynamically across p.numThreads workers, each of which
+ * uses its own clone of the algorithm. The results are returned in the
+ * order of the database, categories that do not pass the size filter are
+ * omitted.
+ */
+static EnrichmentResults scoreCategories(const std::string& name,
+                                         const CategoryDatabase& category_db,
+                                         const Scores& test_set,
+                                         EnrichmentAlgorithmPtr& algorithm,
+                                         const Params& p)
 {
-	Scores subset = test_set.subset(c);
-	subset.sortByName();
+	const size_t n = category_db.size();
+	const size_t numThreads = std::max<size_t>(1, std::min(p.numThreads, n));
 
-	std::string entries;
-	for(const auto& entry : subset.names()) {
-		entries += entry + ',';
+	std::vector<EnrichmentAlgorithmPtr> clones;
+	for(size_t t = 1; t < numThreads; ++t) {
+		clones.emplace_back(algorithm->clone());
 	}
 
-	if(!entries.empty()) {
-		entries.resize(entries.size() - 1);
-	}
+	EnrichmentResults results(n);
+	std::atomic<size_t> next(0);
+	std::mutex output_mutex;
 
-	return std::make_tuple(p.minimum <= c.size() && c.size() <= p.maximum, subset.size(), std::move(entries));
-}
+	internal::runWorkers(numThreads, [&](size_t t) {
+		auto& worker_algorithm = t == 0 ? algorithm : clones[t - 1];
 
-static void writeFiles(const std::string& output_dir, const AllResults& all_results)
-{
+		for(size_t i = next++; i < n; i = next++) {
+			const auto& c = category_db[i];
+			{
+				std::lock_guard<std::mutex> lock(output_mutex);
+				std::cout << "INFO: Processing - " << name << " - "
+				          << c.name() << std::endl;
+			}
 
-	size_t size = 0;
-	for(auto& results_it : all_results) {
-		size += results_it.second.size();
-	}
+			// Check the size before doing any work for the category.
+			if(c.size() < p.minimum || p.maximum < c.size()) {
+				continue;
+			}
+
+			auto ids = hitIds(c, test_set);
+
+			std::shared_ptr<EnrichmentResult> result;
+
+			// TODO: get rid of this
+			auto tmp_cat = std::make_shared<Category>(c);
+			if(!worker_algorithm->canUseCategory(c, ids.size())) {
+				result = std::make_shared<EnrichmentResult>(tmp_cat);
+			} else {
+				result = worker_algorithm->computeEnrichment(tmp_cat);
+			}
+
+			result->hits = ids.size();
+			result->hit_ids = std::move(ids);
+
+			results[i] = std::move(result);
+		}
+	});
 
-	for(const auto& database : all_results) {
-		std::ofstream output(output_dir + "/" + database.first + ".txt");
-		if(database.second.begin() == database.second.end()) {
+	results.erase(std::remove(results.begin(), results.end(), nullptr), results.end());
+
+	algorithm->computeRowWisePValues(results, p.numThreads);
+
+	return results;
+}
+
+static void writeFiles(const std::string& output_dir, const ResultTable& table)
+{
+	for(size_t d = 0; d < table.databases.size(); ++d) {
+		std::ofstream output(output_dir + "/" + table.databases[d] + ".txt");
+		if(table.offsets[d] == table.offsets[d + 1]) {
 			output.close();
 			continue;
 		}
 		if(!output) {
 			throw GeneTrail::IOError("No input file specified.");
 		}
-		output << database.second.begin()->second->header() << std::endl;
-		for(const auto& ele : database.second) {
-			output << *ele.second << std::endl;
+		output << table.results[table.offsets[d]]->header() << std::endl;
+		for(size_t i = table.offsets[d]; i < table.offsets[d + 1]; ++i) {
+			output << *table.results[i] << std::endl;
 		}
 		output.close();
 	}
@@ -166,29 +220,33 @@ int init(GeneSet& test_set, CategoryList& cat_list, const Params& p)
 	return 0;
 }
 
-static void updatePValues(Results& results, const PValueList& pvalues)
+static void updatePValues(ResultTable& table, const PValueList& pvalues)
 {
 	for(const auto& it : pvalues) {
-		results[it.first]->pvalue = it.second;
+		table.results[it.first]->pvalue = it.second;
 	}
 }
 
-static void updatePValues(AllResults& results, const PValueList& pvalues)
-{
-	for(unsigned int i = 0; i < pvalues.size(); ++i) {
-		std::vector<std::string> s;
-		boost::split(s, pvalues[i].first, boost::is_any_of("\t"));
-		results[s[0]][s[1]]->pvalue = pvalues[i].second;
-	}
-}
+using DatabaseQueue =
+    internal::BoundedQueue<std::pair<std::string, CategoryDatabase>>;
 
-static AllResults compute(Scores& test_set, CategoryList& cat_list,
-                   EnrichmentAlgorithmPtr& algorithm, const Params& p)
+/**
+ * Parses the databases of cat_list one after another and passes them to
+ * the queue. Only the first database with a given name that can be read
+ * is used.
+ */
+static void readDatabases(const CategoryList& cat_list,
+                          const std::shared_ptr<EntityDatabase>& db,
+                          DatabaseQueue& queue)
 {
-	AllResults name_to_cat_results;
+	std::vector<std::string> names;
 	for(const auto& cat : cat_list) {
+		if(std::find(names.begin(), names.end(), cat.first) != names.end()) {
+			continue;
+		}
+
 		try {
-			GMTFile input(test_set.db(), cat.second);
+			GMTFile input(db, cat.second);
 
 			if(!input) {
 				std::cerr << "WARNING: Could not open database " + cat.first +
@@ -198,55 +256,151 @@ static AllResults compute(Scores& test_set, CategoryList& cat_list,
 			}
 
 			auto category_db = input.read();
-			Results name_to_result;
-			for(const auto& c : category_db) {
-				std::cout << "INFO: Processing - " << cat.first << " - "
-				          << c.name() << std::endl;
-				auto processed = processCategory(c, test_set, p);
-
-				std::shared_ptr<EnrichmentResult> result;
-
-				if(!std::get<0>(processed)) {
-					continue;
-				}
+			names.push_back(cat.first);
 
-				// TODO: get rid of this
-				auto tmp_cat = std::make_shared<Category>(c);
-				if(!algorithm->canUseCategory(c, std::get<1>(processed))) {
-					result = std::make_shared<EnrichmentResult>(tmp_cat);
-				} else {
-					result = algorithm->computeEnrichment(tmp_cat);
-				}
-
-				result->hits = std::get<1>(processed);
-				result->info = std::move(std::get<2>(processed));
-
-				name_to_result.emplace(c.name(), std::move(result));
+			if(!queue.push(std::make_pair(cat.first, std::move(category_db)))) {
+				return;
 			}
-			name_to_cat_results.emplace(cat.first, std::move(name_to_result));
 		} catch(IOError& exn) {
 			std::cerr << "WARNING: Could not process category file "
 			          << cat.first << "! " << std::endl;
 		}
 	}
+}
+
+static ResultTable compute(Scores& test_set, CategoryList& cat_list,
+                   EnrichmentAlgorithmPtr& algorithm, const Params& p)
+{
+	// The databases are parsed on a separate thread, so the next database
+	// is read while the current one is scored. At most one parsed
+	// database is kept waiting in the queue.
+	//
+	// The reader inserts the names of the parsed categories into the
+	// entity database of test_set while the categories are scored. This
+	// is only safe because scoring works on entity ids alone: no code run
+	// by scoreCategories may look up, insert, or print names, query the
+	// size of the database, or hold a NameRef. Anything that needs names
+	// has to run after reader.join().
+	DatabaseQueue queue(1);
+	std::exception_ptr reader_error;
+
+	std::thread reader([&]() {
+		try {
+			readDatabases(cat_list, test_set.db(), queue);
+		} catch(...) {
+			reader_error = std::current_exception();
+		}
+		queue.close();
+	});
+
+	std::vector<std::pair<std::string, EnrichmentResults>> databases;
+	try {
+		while(auto db = queue.pop()) {
+			try {
+				auto results = scoreCategories(db->first, db->second, test_set, algorithm, p);
+
+				// Sort the categories by name. If a name occurs multiple
+				// times, only the first category is kept.
+				auto by_name = [](const EnrichmentResultPtr& a, const EnrichmentResultPtr& b) {
+					return a->category->name() < b->category->name();
+				};
+				auto equal_name = [](const EnrichmentResultPtr& a, const EnrichmentResultPtr& b) {
+					return a->category->name() == b->category->name();
+				};
+				std::stable_sort(results.begin(), results.end(), by_name);
+				results.erase(std::unique(results.begin(), results.end(), equal_name), results.end());
+
+				databases.emplace_back(std::move(db->first), std::move(results));
+			} catch(IOError& exn) {
+				std::cerr << "WARNING: Could not process category file "
+				          << db->first << "! " << std::endl;
+			}
+		}
+	} catch(...) {
+		queue.close();
+		reader.join();
+		throw;
+	}
+
+	reader.join();
+
+	if(reader_error) {
+		std::rethrow_exception(reader_error);
+	}
 
-	return name_to_cat_results;
+	std::sort(databases.begin(), databases.end(),
+	          [](const std::pair<std::string, EnrichmentResults>& a,
+	             const std::pair<std::string, EnrichmentResults>& b) {
+		          return a.first < b.first;
+		      });
+
+	ResultTable table;
+	table.offsets.push_back(0);
+	for(auto& db : databases) {
+		table.databases.push_back(std::move(db.first));
+		std::move(db.second.begin(), db.second.end(), std::back_inserter(table.results));
+		table.offsets.push_back(table.results.size());
+	}
+
+	return table;
 }
 
-static void adjustCombined(AllResults& all_results, MultipleTestingCorrection correction)
+static void adjustCombined(ResultTable& table, MultipleTestingCorrection correction)
 {
-	auto results = resultVector(all_results);
+	auto results = resultVector(table, 0, table.results.size());
 	results = pvalue::adjustPValues(results, pvalue::get_second(), correction);
-	updatePValues(all_results, results);
+	updatePValues(table, results);
 }
 
-static void adjustSeparately(AllResults& all_results, MultipleTestingCorrection correction)
+static void adjustSeparately(ResultTable& table, MultipleTestingCorrection correction)
 {
-	for(auto& results_it : all_results) {
-		auto results = resultVector(results_it.second);
+	for(size_t d = 0; d < table.databases.size(); ++d) {
+		auto results = resultVector(table, table.offsets[d], table.offsets[d + 1]);
 		results = pvalue::adjustPValues(results, pvalue::get_second(), correction);
-		updatePValues(results_it.second, results);
+		updatePValues(table, results);
+	}
+}
+
+static NullDistributionKey nullDistributionKey(const std::string& statistic,
+                                               const EnrichmentAlgorithmPtr& algorithm,
+                                               const Scores& scores)
+{
+	uint64_t order = algorithm->supportsIndices()
+	                     ? static_cast<uint64_t>(algorithm->getOrder()) + 1
+	                     : 0;
+
+	return NullDistributionKey(statistic, order, scores);
+}
+
+static void buildNullDistributions(RowPermutationTest<double>& test,
+                                   const EnrichmentAlgorithmPtr& algorithm,
+                                   const EnrichmentResults& results,
+                                   const NullDistributionKey& key,
+                                   const std::string& path)
+{
+	std::vector<size_t> sizes;
+	for(const auto& result : results) {
+		sizes.push_back(result->hits);
 	}
+
+	std::sort(sizes.begin(), sizes.end());
+	sizes.erase(std::unique(sizes.begin(), sizes.end()), sizes.end());
+
+	// Keep the distributions that are already contained in the file.
+	NullDistributionCache::Distributions dists;
+	if(boost::filesystem::exists(path)) {
+		NullDistributionCache(path).read(dists);
+	}
+
+	auto null = test.computeNullDistributions(algorithm, sizes);
+
+	for(size_t i = 0; i < sizes.size(); ++i) {
+		auto k = key;
+		k.hits = sizes[i];
+		dists[k] = std::move(null[i]);
+	}
+
+	NullDistributionCache::write(path, dists);
 }
 
 static void computeRowWisePValues(const EnrichmentAlgorithmPtr& algorithm,
@@ -256,9 +410,42 @@ static void computeRowWisePValues(const EnrichmentAlgorithmPtr& algorithm,
 
 	auto test =
 	    algorithm->supportsIndices()
-	        ? Test::IndexBased(scores, p.numPermutations, p.randomSeed)
-	        : Test::CategoryBased(scores, p.numPermutations, p.randomSeed);
+	        ? Test::IndexBased(scores, p.numPermutations, p.randomSeed,
+	                           p.numThreads)
+	        : Test::CategoryBased(scores, p.numPermutations, p.randomSeed,
+	                              p.numThreads);
+
+	test->setEarlyStoppingHits(p.earlyStoppingHits);
 
+	if(p.nullDistributions.empty()) {
+		test->computePValue(algorithm, results);
+		return;
+	}
+
+	if(p.statistic.empty()) {
+		std::cerr << "WARNING: This method does not support null distributions.\n"
+		          << "WARNING: Falling back to permutations." << std::endl;
+		test->computePValue(algorithm, results);
+		return;
+	}
+
+	auto key = nullDistributionKey(p.statistic, algorithm, scores);
+
+	std::unique_ptr<NullDistributionCache> cache;
+	try {
+		if(p.buildNullDistributions) {
+			buildNullDistributions(*test, algorithm, results, key,
+			                       p.nullDistributions);
+		}
+
+		cache = std::make_unique<NullDistributionCache>(p.nullDistributions);
+	} catch(IOError& exn) {
+		std::cerr << "WARNING: Could not use the null distributions. Reason: "
+		          << exn.what() << "\n"
+		          << "WARNING: Falling back to permutations." << std::endl;
+	}
+
+	test->setNullDistributions(cache.get(), key);
 	test->computePValue(algorithm, results);
 }
 
@@ -336,12 +523,13 @@ static void computeColumnWisePValues(const EnrichmentAlgorithmPtr& algorithm,
 	if(p.adjustment && p.adjustment == MultipleTestingCorrection::GSEA) {
 		KSColumnPermutationTest<double> test(
 		    data, p.numPermutations, referenceGroup.size(),
-		    p.scoringMethod.get(), p.randomSeed, db);
+		    p.scoringMethod.get(), p.randomSeed, db, p.numThreads);
 		test.computePValue(algorithm, results);
 	} else {
 		ColumnPermutationTest<double> test(
 		    data, p.numPermutations, referenceGroup.size(),
-		    p.scoringMethod.get(), p.randomSeed, db);
+		    p.scoringMethod.get(), p.randomSeed, db, p.numThreads);
+		test.setEarlyStoppingHits(p.earlyStoppingHits);
 		test.computePValue(algorithm, results);
 	}
 }
@@ -356,18 +544,11 @@ computeRestandardizationPValues(const EnrichmentAlgorithmPtr&)
 }
 
 static void computePValues(EnrichmentAlgorithmPtr& algorithm,
-                    const AllResults& name_to_cat_results, const Scores& scores, const Params& p)
+                    const ResultTable& table, const Scores& scores, const Params& p)
 {
-	EnrichmentResults results;
-
-	// TODO: This is really inefficient and clumsy
-	//      we should have a better way of getting the necessary stuff
-	//      together for pvalue computation.
-	for(const auto& db : name_to_cat_results) {
-		for(const auto& result : db.second) {
-			results.push_back(result.second);
-		}
-	}
+	// The permutation tests reorder the results, so we pass a copy
+	// of the pointers.
+	EnrichmentResults results(table.results);
 
 	switch(algorithm->pValueMode()) {
 		case PValueMode::RowWise:
@@ -387,19 +568,19 @@ void run(Scores& test_set, CategoryList& cat_list,
 {
 	test_set.sortByIndex();
 
-	AllResults name_to_cat_results(compute(test_set, cat_list, algorithm, p));
+	ResultTable table(compute(test_set, cat_list, algorithm, p));
 	if(computePValue && !algorithm->pValuesComputed()) {
-		computePValues(algorithm, name_to_cat_results, test_set, p);
+		computePValues(algorithm, table, test_set, p);
 	}
 
 	if(p.adjustment && boost::get(p.adjustment) != MultipleTestingCorrection::GSEA) {
 		// Checks how they should be adjusted
 		if(p.adjustSeparately) {
-			adjustSeparately(name_to_cat_results, p.adjustment.get());
+			adjustSeparately(table, p.adjustment.get());
 		} else {
-			adjustCombined(name_to_cat_results, p.adjustment.get());
+			adjustCombined(table, p.adjustment.get());
 		}
 	}
 
-	writeFiles(p.out(), name_to_cat_results);
+	writeFiles(p.out(), table);
 }
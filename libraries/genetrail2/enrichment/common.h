@@ -23,6 +23,7 @@
 
 #include "CommandLineInterface.h"
 #include "EnrichmentAlgorithm.h"
+#include "EnrichmentResult.h"
 
 #include <genetrail2/core/MatrixHTest.h>
 #include <genetrail2/core/macros.h>
@@ -45,16 +46,32 @@ namespace GeneTrail
 	class GeneSet;
 
 	struct DirectoryPath;
-	struct EnrichmentResult;
 	struct FilePath;
 	struct Params;
 
 	using EnrichmentAlgorithmPtr = std::unique_ptr<EnrichmentAlgorithm>;
 }
 
-typedef std::map<std::string, std::shared_ptr<EnrichmentResult>> Results;
-typedef std::map<std::string, Results> AllResults;
-typedef std::vector<std::pair<std::string, double>> PValueList;
+/**
+ * The results of all categories of all databases. The databases are
+ * sorted by name and the rows of database d are the range
+ * [offsets[d], offsets[d + 1]) of results, sorted by category name.
+ * Rows are identified by their position, so no string keys are needed
+ * when passing results between the pipeline stages.
+ *
+ * The rows are not stored in columns: every row is a separately allocated
+ * EnrichmentResult, as the algorithms, the permutation tests and the
+ * output all operate on these objects. Only the pointers are contiguous.
+ */
+struct GT2_EXPORT ResultTable
+{
+	std::vector<std::string> databases;
+	std::vector<size_t> offsets;
+	EnrichmentResults results;
+};
+
+/// Pairs of row index and p-value used for multiple testing correction.
+typedef std::vector<std::pair<size_t, double>> PValueList;
 
 using CategoryList = std::list<std::pair<std::string, std::string>>;
 
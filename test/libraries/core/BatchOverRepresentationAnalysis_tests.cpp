@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include <genetrail2/core/BatchOverRepresentationAnalysis.h>
+#include <genetrail2/core/Category.h>
+#include <genetrail2/core/CategoryDatabase.h>
+#include <genetrail2/core/EntityDatabase.h>
+#include <genetrail2/core/OverRepresentationAnalysis.h>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace GeneTrail;
+
+class BatchOverRepresentationAnalysisTest : public ::testing::Test
+{
+	protected:
+	BatchOverRepresentationAnalysisTest()
+	    : db(std::make_shared<EntityDatabase>()),
+	      categories(db),
+	      reference(db.get())
+	{
+		std::mt19937 rng(3);
+		std::bernoulli_distribution coin(0.1);
+
+		for(size_t i = 0; i < 500; ++i) {
+			reference.insert(i);
+		}
+
+		for(size_t j = 0; j < 50; ++j) {
+			auto& c = categories.addCategory();
+			for(size_t i = 0; i < 600; ++i) {
+				if(coin(rng)) {
+					c.insert(i);
+				}
+			}
+		}
+
+		// A subset of the reference and a set containing unknown genes
+		Category subset(db.get());
+		Category superset(db.get());
+		for(size_t i = 0; i < 600; ++i) {
+			if(coin(rng)) {
+				(i < 500 ? subset : superset).insert(i);
+			}
+		}
+		test_sets = {subset, superset};
+	}
+
+	std::shared_ptr<EntityDatabase> db;
+	CategoryDatabase categories;
+	Category reference;
+	std::vector<Category> test_sets;
+};
+
+TEST_F(BatchOverRepresentationAnalysisTest, hits)
+{
+	BatchOverRepresentationAnalysis batch(categories, reference);
+
+	ASSERT_EQ(categories.size(), batch.numCategories());
+
+	for(const auto& test_set : test_sets) {
+		auto hits = batch.hits(test_set);
+		for(const auto& hit : hits) {
+			EXPECT_EQ(Category::intersect("", categories[hit.first], test_set).size(),
+			          hit.second);
+		}
+	}
+}
+
+TEST_F(BatchOverRepresentationAnalysisTest, compareToOverRepresentationAnalysis)
+{
+	BatchOverRepresentationAnalysis batch(categories, reference);
+
+	auto results = batch.compute(test_sets);
+	ASSERT_EQ(test_sets.size(), results.size());
+
+	for(size_t t = 0; t < test_sets.size(); ++t) {
+		OverRepresentationAnalysis ora(reference, test_sets[t]);
+
+		ASSERT_EQ(categories.size(), results[t].size());
+		for(size_t j = 0; j < categories.size(); ++j) {
+			EXPECT_EQ(ora.numberOfHits(categories[j]), results[t][j].hits);
+			EXPECT_DOUBLE_EQ(ora.expectedNumberOfHits(categories[j]),
+			                 results[t][j].expected_hits);
+			EXPECT_DOUBLE_EQ(ora.computePValue(categories[j]),
+			                 results[t][j].pvalue);
+		}
+	}
+}
@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+
+#include <genetrail2/core/ConcurrentEntityDatabase.h>
+#include <genetrail2/core/Exception.h>
+
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace GeneTrail;
+
+TEST(ConcurrentEntityDatabase, index)
+{
+	ConcurrentEntityDatabase db;
+
+	EXPECT_EQ(0u, db.index("A"));
+	EXPECT_EQ(1u, db.index("B"));
+	EXPECT_EQ(0u, db.index("A"));
+	EXPECT_EQ(2u, db.size());
+
+	EXPECT_EQ("A", db.name(0));
+	EXPECT_EQ("B", db(1));
+
+	const ConcurrentEntityDatabase& cdb = db;
+	EXPECT_EQ(1u, cdb.index("B"));
+	EXPECT_THROW(cdb.index("C"), UnknownEntry);
+}
+
+TEST(ConcurrentEntityDatabase, freeze)
+{
+	ConcurrentEntityDatabase db;
+
+	db.index("A");
+	EXPECT_FALSE(db.isFrozen());
+
+	db.freeze();
+	EXPECT_TRUE(db.isFrozen());
+
+	EXPECT_EQ(0u, db.index("A"));
+	EXPECT_THROW(db.index("B"), UnknownEntry);
+	EXPECT_EQ(1u, db.size());
+}
+
+TEST(ConcurrentEntityDatabase, concurrentInsertion)
+{
+	const size_t numThreads = 4;
+	// Odd strides visit every name when the count is a power of two.
+	const size_t numNames = 1 << 14;
+
+	ConcurrentEntityDatabase db;
+
+	// All threads insert the same names in different orders, so most
+	// names are contended.
+	std::vector<std::vector<ConcurrentEntityDatabase::index_type>> ids(
+	    numThreads);
+	std::vector<std::thread> threads;
+	for(size_t t = 0; t < numThreads; ++t) {
+		threads.emplace_back([&db, &ids, t, numNames]() {
+			ids[t].resize(numNames);
+			for(size_t k = 0; k < numNames; ++k) {
+				const size_t i = (k * (2 * t + 1)) % numNames;
+				ids[t][i] = db.index("ENSG" + std::to_string(i));
+			}
+		});
+	}
+
+	// Every id below size() must be accessible while the others insert.
+	std::thread reader([&db, numNames]() {
+		size_t checked = 0;
+		while(checked < numNames) {
+			for(const size_t n = db.size(); checked < n; ++checked) {
+				EXPECT_EQ(0u, db.name(checked).find("ENSG"));
+			}
+		}
+	});
+
+	for(auto& thread : threads) {
+		thread.join();
+	}
+	reader.join();
+
+	db.freeze();
+	ASSERT_EQ(numNames, db.size());
+
+	std::set<ConcurrentEntityDatabase::index_type> unique(ids[0].begin(),
+	                                                      ids[0].end());
+	EXPECT_EQ(numNames, unique.size());
+
+	for(size_t i = 0; i < numNames; ++i) {
+		const auto name = "ENSG" + std::to_string(i);
+		for(size_t t = 1; t < numThreads; ++t) {
+			EXPECT_EQ(ids[0][i], ids[t][i]);
+		}
+		EXPECT_EQ(name, db.name(ids[0][i]));
+		EXPECT_EQ(ids[0][i], db.index(name));
+	}
+
+	const auto plain = db.toEntityDatabase();
+	ASSERT_EQ(numNames, plain.size());
+	for(size_t i = 0; i < numNames; ++i) {
+		EXPECT_EQ(db.name(i), plain.name(i));
+	}
+}
@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include <genetrail2/core/Category.h>
+#include <genetrail2/core/EntityBitset.h>
+#include <genetrail2/core/EntityDatabase.h>
+
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <vector>
+
+using namespace GeneTrail;
+
+TEST(EntityBitset, setAndTest)
+{
+	EntityBitset bits(130);
+
+	bits.set(0);
+	bits.set(64);
+	bits.set(129);
+
+	EXPECT_EQ(130u, bits.size());
+	EXPECT_EQ(3u, bits.count());
+	EXPECT_TRUE(bits.test(0));
+	EXPECT_TRUE(bits.test(64));
+	EXPECT_TRUE(bits.test(129));
+	EXPECT_FALSE(bits.test(1));
+	EXPECT_FALSE(bits.test(130));
+	EXPECT_FALSE(bits.test(100000));
+}
+
+TEST(EntityBitset, intersectionWithCategory)
+{
+	EntityDatabase db;
+	std::vector<size_t> a{1, 5, 7, 200, 300};
+	std::vector<size_t> b{0, 5, 7, 300, 5000};
+
+	EntityBitset bits(Category(&db, a.begin(), a.end()));
+
+	EXPECT_EQ(301u, bits.size());
+	EXPECT_EQ(5u, bits.count());
+	EXPECT_EQ(3u, bits.intersectionSize(Category(&db, b.begin(), b.end())));
+	EXPECT_EQ(0u, EntityBitset(Category(&db)).count());
+}
+
+TEST(EntityBitset, intersectionWithBitset)
+{
+	std::mt19937 rng(7);
+	std::bernoulli_distribution coin(0.3);
+
+	// Use sizes that are not a multiple of the vector width.
+	for(size_t size : {1, 63, 64, 257, 1000, 20011}) {
+		EntityBitset a(size);
+		EntityBitset b(size + 100);
+		std::vector<size_t> ids_a, ids_b;
+
+		for(size_t i = 0; i < size; ++i) {
+			if(coin(rng)) {
+				a.set(i);
+				ids_a.push_back(i);
+			}
+			if(coin(rng)) {
+				b.set(i);
+				ids_b.push_back(i);
+			}
+		}
+
+		std::vector<size_t> expected;
+		std::set_intersection(ids_a.begin(), ids_a.end(), ids_b.begin(),
+		                      ids_b.end(), std::back_inserter(expected));
+
+		EXPECT_EQ(expected.size(), EntityBitset::intersectionSize(a, b));
+		EXPECT_EQ(expected.size(), EntityBitset::intersectionSize(b, a));
+	}
+}
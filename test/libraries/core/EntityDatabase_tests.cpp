@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+
+#include <genetrail2/core/EntityDatabase.h>
+#include <genetrail2/core/Exception.h>
+
+#include <string>
+
+using namespace GeneTrail;
+
+TEST(EntityDatabase, index)
+{
+	EntityDatabase db;
+
+	EXPECT_EQ(0u, db.index("A"));
+	EXPECT_EQ(1u, db.index("B"));
+	EXPECT_EQ(0u, db.index("A"));
+	EXPECT_EQ(2u, db.index(""));
+	EXPECT_EQ(3u, db.size());
+
+	EXPECT_EQ("A", db.name(0));
+	EXPECT_EQ("B", db(1));
+	EXPECT_EQ("", db.name(2));
+}
+
+TEST(EntityDatabase, constIndex)
+{
+	EntityDatabase db;
+	const EntityDatabase& cdb = db;
+
+	EXPECT_THROW(cdb.index("A"), UnknownEntry);
+
+	db.index("A");
+	EXPECT_EQ(0u, cdb.index("A"));
+	EXPECT_THROW(cdb.index("B"), UnknownEntry);
+}
+
+TEST(EntityDatabase, manyEntities)
+{
+	EntityDatabase db;
+
+	for(size_t i = 0; i < 10000; ++i) {
+		EXPECT_EQ(i, db.index("ENSG" + std::to_string(i)));
+	}
+
+	ASSERT_EQ(10000u, db.size());
+
+	const EntityDatabase& cdb = db;
+	for(size_t i = 0; i < 10000; ++i) {
+		const auto name = "ENSG" + std::to_string(i);
+		EXPECT_EQ(name, db.name(i));
+		EXPECT_EQ(i, cdb.index(name));
+	}
+}
+
+TEST(EntityDatabase, clear)
+{
+	EntityDatabase db;
+
+	db.index("A");
+	db.index("B");
+	db.clear();
+
+	EXPECT_EQ(0u, db.size());
+	EXPECT_EQ(0u, db.index("B"));
+	EXPECT_EQ("B", db.name(0));
+}
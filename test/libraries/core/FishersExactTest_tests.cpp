@@ -30,3 +30,10 @@ TEST(FishersExactTest, upperTailedPValue){
 	FishersExactTest<unsigned int, double> fet;
 	EXPECT_NEAR(fet.upperTailedPValue(14,9,10,7), 0.3266478 + 0.1837394 + 0.04666397 + 0.004083098, TOLERANCE);
 }
+
+TEST(FishersExactTest, logFactorialTable){
+	FishersExactTest<unsigned int, double> fet(std::make_shared<LogFactorialTable>(100));
+	EXPECT_NEAR(fet.compute(14,6,10,6), 0.2332077, TOLERANCE);
+	EXPECT_NEAR(fet.lowerTailedPValue(14,9,10,3), 0.08884103 + 0.01665769 + 0.001346076 + 0.000033652, TOLERANCE);
+	EXPECT_NEAR(fet.upperTailedPValue(14,9,10,7), 0.3266478 + 0.1837394 + 0.04666397 + 0.004083098, TOLERANCE);
+}
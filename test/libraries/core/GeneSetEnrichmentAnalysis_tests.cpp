@@ -93,3 +93,117 @@ TEST(GeneSetEnrichmentAnalysis, smallExampleIndices2) {
 	EXPECT_EQ(-30, max_RSc);
 }
 
+
+TEST(GeneSetEnrichmentAnalysis, smallExampleIndicesLeadingDip) {
+	/*
+	 * The running sum drops below zero before the first category
+	 * member is found and only returns to zero at the end:
+	 *
+	 * 0 | 1 | 2 | 3 | 4 | 5 | 6 | 7 | 8 | 9
+	 * 0 | 0 | 0 | 0 | 0 | 0 | 0 | 1 | 1 | 1
+	 */
+	std::vector<size_t> indices { 7, 8, 9 };
+
+	EntityDatabase db;
+	std::vector<std::string> test;
+	Category cat(&db);
+	for(size_t i = 0; i < 10; ++i) {
+		test.push_back(boost::lexical_cast<std::string>(i));
+	}
+	for(auto i : indices) {
+		cat.insert(test[i]);
+	}
+
+	GeneSetEnrichmentAnalysis<double, int64_t> gsea;
+	EXPECT_EQ(-21, gsea.computeRunningSum(cat, test.begin(), test.end()));
+	EXPECT_EQ(-21, gsea.computeRunningSum(10, indices.begin(), indices.end()));
+
+	std::vector<std::vector<size_t>::const_iterator> begins { indices.cbegin() };
+	GeneSetEnrichmentAnalysis<double, int64_t>::RunningSumBuffers buffers;
+	std::vector<int64_t> scores(1);
+	gsea.computeRunningSums(10, begins, 3, scores.begin(), buffers);
+	EXPECT_EQ(-21, scores[0]);
+}
+
+TEST(GeneSetEnrichmentAnalysis, batchedRunningSums) {
+	std::vector<std::vector<size_t>> ranges {
+		{ 1, 3, 4 },
+		{ 0, 7, 9 },
+		{ 5, 6, 8 },
+		{ 0, 1, 2 }
+	};
+
+	std::vector<std::vector<size_t>::const_iterator> begins;
+	for(const auto& r : ranges) {
+		begins.push_back(r.cbegin());
+	}
+
+	GeneSetEnrichmentAnalysis<double, int64_t> gsea;
+	GeneSetEnrichmentAnalysis<double, int64_t>::RunningSumBuffers buffers;
+	std::vector<int64_t> scores(ranges.size());
+	gsea.computeRunningSums(10, begins, 3, scores.begin(), buffers);
+
+	for(size_t i = 0; i < ranges.size(); ++i) {
+		EXPECT_EQ(gsea.computeRunningSum(10, ranges[i].begin(), ranges[i].end()), scores[i]);
+	}
+
+	EXPECT_EQ(15, scores[0]);
+
+	// Reusing the buffers for fewer and shorter ranges must not leak
+	// state from the previous call.
+	begins.pop_back();
+	gsea.computeRunningSums(10, begins, 2, scores.begin(), buffers);
+
+	for(size_t i = 0; i < begins.size(); ++i) {
+		EXPECT_EQ(gsea.computeRunningSum(10, ranges[i].begin(), ranges[i].begin() + 2), scores[i]);
+	}
+}
+
+TEST(GeneSetEnrichmentAnalysis, bandPValueMatchesPathCounting) {
+	GeneSetEnrichmentAnalysis<big_float, int64_t> gsea;
+
+	auto two = [](int64_t v, int64_t RSc) { return std::abs(v) < RSc; };
+	auto right = [](int64_t v, int64_t RSc) { return v < RSc; };
+	auto left = [](int64_t v, int64_t RSc) { return -RSc < v; };
+
+	for(size_t n : {10, 57, 300}) {
+		for(size_t l : {1, 3, 8, 20}) {
+			const int64_t max = l * (n - l);
+			for(int64_t RSc = 0; RSc <= max; RSc += std::max<int64_t>(1, max / 37)) {
+				double p2 = gsea.computeTwoSidedPValue(n, l, RSc).convert_to<double>();
+				double pr = gsea.computeRightPValue(n, l, RSc).convert_to<double>();
+				double pl = gsea.computeLeftPValue(n, l, RSc).convert_to<double>();
+
+				double e2 = gsea.computePValue_(n, l, RSc, two).convert_to<double>();
+				double er = gsea.computePValue_(n, l, RSc, right).convert_to<double>();
+				double el = gsea.computePValue_(n, l, RSc, left).convert_to<double>();
+
+				EXPECT_NEAR(e2, p2, 1e-10 * e2 + 1e-300) << n << " " << l << " " << RSc;
+				EXPECT_NEAR(er, pr, 1e-10 * er + 1e-300) << n << " " << l << " " << RSc;
+				EXPECT_NEAR(el, pl, 1e-10 * el + 1e-300) << n << " " << l << " " << RSc;
+			}
+		}
+	}
+}
+
+TEST(GeneSetEnrichmentAnalysis, batchedPValues) {
+	GeneSetEnrichmentAnalysis<big_float, int64_t> gsea;
+
+	const size_t n = 200;
+	const size_t l = 12;
+	std::vector<int64_t> RScs { 0, 50, -100, 400, 700, 1100, 1500, 2376 };
+
+	auto two = gsea.computeTwoSidedPValues(n, l, RScs);
+	auto right = gsea.computeRightPValues(n, l, RScs);
+	auto left = gsea.computeLeftPValues(n, l, RScs);
+
+	ASSERT_EQ(RScs.size(), two.size());
+	ASSERT_EQ(RScs.size(), right.size());
+	ASSERT_EQ(RScs.size(), left.size());
+
+	for(size_t i = 0; i < RScs.size(); ++i) {
+		EXPECT_EQ(gsea.computeTwoSidedPValue(n, l, RScs[i]), two[i]);
+		EXPECT_EQ(gsea.computeRightPValue(n, l, RScs[i]), right[i]);
+		EXPECT_EQ(gsea.computeLeftPValue(n, l, RScs[i]), left[i]);
+	}
+}
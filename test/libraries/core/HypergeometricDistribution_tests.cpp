@@ -0,0 +1,117 @@
+#include <genetrail2/core/HypergeometricDistribution.h>
+#include <genetrail2/core/HypergeometricTest.h>
+#include <genetrail2/core/multiprecision.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+using namespace GeneTrail;
+
+const double RELATIVE_TOLERANCE = 1e-9;
+
+/*
+ * Compares the double precision tails to the multiprecision
+ * implementation for a single value of k.
+ */
+static void compareTailsAt(uint64_t m, uint64_t l, uint64_t n, uint64_t k)
+{
+	HypergeometricTest<uint64_t, big_float> h;
+
+	double lower = h.lowerTailedPValue(m, l, n, k).convert_to<double>();
+	double upper = h.upperTailedPValue(m, l, n, k).convert_to<double>();
+
+	auto fastLower = hypergeometric::lowerTail(m, l, n, k);
+	auto fastUpper = hypergeometric::upperTail(m, l, n, k);
+
+	if(fastLower) {
+		EXPECT_NEAR(lower, *fastLower, RELATIVE_TOLERANCE * lower)
+		    << m << " " << l << " " << n << " " << k;
+	} else {
+		EXPECT_LT(lower, 1e-300);
+	}
+
+	if(fastUpper) {
+		EXPECT_NEAR(upper, *fastUpper, RELATIVE_TOLERANCE * upper)
+		    << m << " " << l << " " << n << " " << k;
+	} else {
+		EXPECT_LT(upper, 1e-300);
+	}
+}
+
+/*
+ * Compares the tails for all possible values of k.
+ */
+static void compareTails(uint64_t m, uint64_t l, uint64_t n)
+{
+	const uint64_t first = n > m - l ? n + l - m : 0;
+	const uint64_t last = std::min(l, n);
+
+	for(uint64_t k = first; k <= last; ++k) {
+		compareTailsAt(m, l, n, k);
+	}
+}
+
+/*
+ * Compares the tails for both ends of the support, the values around the
+ * mode and a few interior points. The multiprecision reference is too
+ * slow for sweeping the whole support of large distributions.
+ */
+static void sampleTails(uint64_t m, uint64_t l, uint64_t n)
+{
+	const uint64_t first = n > m - l ? n + l - m : 0;
+	const uint64_t last = std::min(l, n);
+	const uint64_t mode = (n + 1) * (l + 1) / (m + 2);
+
+	std::vector<uint64_t> ks{first, first + 1, mode - 1, mode, mode + 1,
+	                         last - 1, last};
+	for(uint64_t i = 1; i < 4; ++i) {
+		ks.push_back(first + i * (last - first) / 4);
+	}
+
+	for(auto k : ks) {
+		if(first <= k && k <= last) {
+			compareTailsAt(m, l, n, k);
+		}
+	}
+}
+
+TEST(HypergeometricDistribution, logProbability)
+{
+	HypergeometricTest<uint64_t, big_float> h;
+	double p = h.compute(7442, 34, 699, 5).convert_to<double>();
+	EXPECT_NEAR(std::log(p), hypergeometric::logProbability(7442, 34, 699, 5),
+	            1e-10);
+	EXPECT_EQ(-INFINITY, hypergeometric::logProbability(50, 5, 10, 6));
+}
+
+TEST(HypergeometricDistribution, compareToMultiprecisionSmall)
+{
+	compareTails(50, 5, 10);
+	compareTails(50, 45, 10);
+	compareTails(20, 12, 15);
+	compareTails(10, 10, 3);
+}
+
+TEST(HypergeometricDistribution, compareToMultiprecisionLarge)
+{
+	sampleTails(7442, 34, 699);
+	sampleTails(22799, 391, 1139);
+	sampleTails(20000, 500, 2000);
+}
+
+TEST(HypergeometricDistribution, outsideOfSupport)
+{
+	EXPECT_EQ(1.0, *hypergeometric::upperTail(50, 5, 10, 0));
+	EXPECT_EQ(0.0, *hypergeometric::upperTail(50, 5, 10, 6));
+	EXPECT_EQ(1.0, *hypergeometric::lowerTail(50, 5, 10, 5));
+	EXPECT_EQ(0.0, *hypergeometric::lowerTail(20, 12, 15, 6));
+}
+
+TEST(HypergeometricDistribution, underflow)
+{
+	// The probability of drawing all 1000 successes is far below the
+	// smallest normalised double.
+	EXPECT_FALSE(hypergeometric::upperTail(20000, 1000, 1000, 1000));
+}
@@ -117,3 +117,11 @@ TEST(HypergeometricTest, upperTailedPValueBounds) {
 	EXPECT_NEAR(h.upperTailedPValue(28, 8, 10, 6).convert_to<double>(), 1.447828e-05 + 0.0006949572 + 0.01033749, TOLERANCE);
 }
 
+
+TEST(HypergeometricTest, logFactorialTable) {
+	HypergeometricTest<unsigned int, big_float> h;
+	HypergeometricTest<unsigned int, big_float> t(std::make_shared<LogFactorialTable>(25000));
+	EXPECT_NEAR(h.compute(7442,34,699,5).convert_to<double>(), t.compute(7442,34,699,5).convert_to<double>(), 1e-10);
+	EXPECT_NEAR(h.lowerTailedPValue(22799,391,1139,2).convert_to<double>(), t.lowerTailedPValue(22799,391,1139,2).convert_to<double>(), 1e-15);
+	EXPECT_NEAR(h.upperTailedPValue(22799,72,1139,4).convert_to<double>(), t.upperTailedPValue(22799,72,1139,4).convert_to<double>(), 1e-10);
+}
@@ -0,0 +1,168 @@
+#include <genetrail2/core/Exception.h>
+#include <genetrail2/core/GeneSetEnrichmentAnalysis.h>
+#include <genetrail2/core/KolmogorovSmirnovPValueCache.h>
+#include <genetrail2/core/multiprecision.h>
+
+#include <gtest/gtest.h>
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+#include <limits>
+
+using namespace GeneTrail;
+
+namespace bfs = boost::filesystem;
+
+using Side = KolmogorovSmirnovPValueCache::Side;
+
+TEST(KolmogorovSmirnovPValueCache, pValue)
+{
+	GeneSetEnrichmentAnalysis<big_float, int64_t> gsea;
+	KolmogorovSmirnovPValueCache cache;
+
+	EXPECT_EQ(gsea.computeRightPValue(100, 10, 300).convert_to<double>(),
+	          cache.pValue(100, 10, 300, Side::Right));
+	EXPECT_EQ(gsea.computeLeftPValue(100, 10, -300).convert_to<double>(),
+	          cache.pValue(100, 10, -300, Side::Left));
+	EXPECT_EQ(gsea.computeTwoSidedPValue(100, 10, 300).convert_to<double>(),
+	          cache.pValue(100, 10, 300, Side::TwoSided));
+	EXPECT_EQ(3u, cache.size());
+
+	cache.pValue(100, 10, 300, Side::Right);
+	EXPECT_EQ(3u, cache.size());
+}
+
+TEST(KolmogorovSmirnovPValueCache, precompute)
+{
+	KolmogorovSmirnovPValueCache cache;
+	KolmogorovSmirnovPValueCache reference;
+
+	std::vector<int64_t> RScs{150, 900, 300, 150, 600, 450, 750};
+	cache.precompute(100, 10, RScs, Side::Right);
+	EXPECT_EQ(6u, cache.size());
+
+	for(auto RSc : RScs) {
+		EXPECT_EQ(reference.pValue(100, 10, RSc, Side::Right),
+		          cache.pValue(100, 10, RSc, Side::Right));
+	}
+	EXPECT_EQ(6u, cache.size());
+}
+
+TEST(KolmogorovSmirnovPValueCache, writeAndRead)
+{
+	auto path = bfs::temp_directory_path() / bfs::unique_path();
+
+	KolmogorovSmirnovPValueCache cache;
+	cache.precompute(300, 20, {500, 1000, 2000}, Side::Left);
+	cache.write(path.string());
+
+	KolmogorovSmirnovPValueCache read;
+	read.read(path.string());
+	bfs::remove(path);
+
+	ASSERT_EQ(3u, read.size());
+	for(int64_t RSc : {500, 1000, 2000}) {
+		EXPECT_EQ(cache.pValue(300, 20, RSc, Side::Left),
+		          read.pValue(300, 20, RSc, Side::Left));
+	}
+	EXPECT_EQ(3u, read.size());
+}
+
+TEST(KolmogorovSmirnovPValueCache, writeReplacesFile)
+{
+	auto directory = bfs::temp_directory_path() / bfs::unique_path();
+	bfs::create_directory(directory);
+	auto path = (directory / "pvalues.bin").string();
+
+	KolmogorovSmirnovPValueCache cache;
+	cache.precompute(300, 20, {500, 1000, 2000}, Side::Left);
+	cache.write(path);
+
+	KolmogorovSmirnovPValueCache smaller;
+	smaller.precompute(300, 20, {500}, Side::Left);
+	smaller.write(path);
+
+	KolmogorovSmirnovPValueCache read;
+	read.read(path);
+	EXPECT_EQ(1u, read.size());
+
+	// Only the target remains, no temporary file.
+	EXPECT_EQ(1, std::distance(bfs::directory_iterator(directory),
+	                           bfs::directory_iterator()));
+	bfs::remove_all(directory);
+}
+
+TEST(KolmogorovSmirnovPValueCache, readInvalidFile)
+{
+	KolmogorovSmirnovPValueCache cache;
+	EXPECT_THROW(cache.read("/this/file/does/not/exist"), IOError);
+}
+
+namespace
+{
+	/**
+	 * Writes a cache containing a single entry and overwrites the given
+	 * bytes of that entry afterwards. The entry starts after the magic
+	 * number and the entry count.
+	 */
+	template <typename T>
+	void corruptEntry(const std::string& path, std::streamoff offset, T value)
+	{
+		KolmogorovSmirnovPValueCache cache;
+		cache.precompute(300, 20, {500}, Side::Left);
+		cache.write(path);
+
+		std::fstream strm(path,
+		                  std::ios::in | std::ios::out | std::ios::binary);
+		strm.seekp(16 + offset);
+		strm.write(reinterpret_cast<const char*>(&value), sizeof(value));
+	}
+}
+
+TEST(KolmogorovSmirnovPValueCache, rejectsCorruptEntries)
+{
+	auto path = (bfs::temp_directory_path() / bfs::unique_path()).string();
+
+	// Key layout: n, l, RSc, side, followed by the p-value. The entry
+	// count directly precedes the entry.
+	const std::streamoff n = 0, side = 24, pvalue = 32;
+
+	corruptEntry(path, side, uint64_t(3));
+	KolmogorovSmirnovPValueCache invalidSide;
+	EXPECT_THROW(invalidSide.read(path), IOError);
+
+	corruptEntry(path, n, uint64_t(10));
+	KolmogorovSmirnovPValueCache tooFewGenes;
+	EXPECT_THROW(tooFewGenes.read(path), IOError);
+
+	corruptEntry(path, pvalue, 1.5);
+	KolmogorovSmirnovPValueCache tooLarge;
+	EXPECT_THROW(tooLarge.read(path), IOError);
+
+	corruptEntry(path, pvalue, -0.5);
+	KolmogorovSmirnovPValueCache negative;
+	EXPECT_THROW(negative.read(path), IOError);
+
+	corruptEntry(path, pvalue, std::numeric_limits<double>::quiet_NaN());
+	KolmogorovSmirnovPValueCache nan;
+	EXPECT_THROW(nan.read(path), IOError);
+
+	// Claim more entries than the file holds.
+	corruptEntry(path, -8, std::numeric_limits<uint64_t>::max());
+	KolmogorovSmirnovPValueCache tooLong;
+	EXPECT_THROW(tooLong.read(path), IOError);
+
+	// Nothing of the corrupt files may end up in the cache.
+	EXPECT_EQ(0u, invalidSide.size());
+	EXPECT_EQ(0u, tooLong.size());
+
+	// An intact entry is still accepted.
+	corruptEntry(path, pvalue, 0.25);
+	KolmogorovSmirnovPValueCache valid;
+	valid.read(path);
+	EXPECT_EQ(1u, valid.size());
+	EXPECT_EQ(0.25, valid.pValue(300, 20, 500, Side::Left));
+
+	bfs::remove(path);
+}
@@ -0,0 +1,61 @@
+#include <genetrail2/core/Exception.h>
+#include <genetrail2/core/LogFactorialTable.h>
+
+#include <gtest/gtest.h>
+
+#include <boost/filesystem.hpp>
+
+#include <cmath>
+
+using namespace GeneTrail;
+
+namespace bfs = boost::filesystem;
+
+TEST(LogFactorialTable, values)
+{
+	LogFactorialTable table(100);
+
+	ASSERT_EQ(100u, table.max());
+	EXPECT_EQ(0.0, table.logFactorial(0));
+	EXPECT_EQ(0.0, table.logFactorial(1));
+	EXPECT_NEAR(std::log(120.0), table.logFactorial(5), 1e-12);
+	EXPECT_NEAR(std::log(252.0), table.logBinomial(10, 5), 1e-12);
+	EXPECT_NEAR(0.0, table.logBinomial(100, 100), 1e-12);
+}
+
+TEST(LogFactorialTable, writeAndRead)
+{
+	auto path = bfs::temp_directory_path() / bfs::unique_path();
+
+	LogFactorialTable table(1000);
+	table.write(path.string());
+	auto read = LogFactorialTable::read(path.string());
+	bfs::remove(path);
+
+	ASSERT_EQ(table.max(), read.max());
+	for(size_t i = 0; i <= table.max(); ++i) {
+		EXPECT_EQ(table.logFactorial(i), read.logFactorial(i));
+	}
+}
+
+TEST(LogFactorialTable, readInvalidFile)
+{
+	EXPECT_THROW(LogFactorialTable::read("/this/file/does/not/exist"),
+	             IOError);
+}
+
+TEST(LogFactorialTable, get)
+{
+	auto directory = bfs::temp_directory_path() / bfs::unique_path();
+	bfs::create_directory(directory);
+	LogFactorialTable::setCacheDirectory(directory.string());
+
+	auto a = LogFactorialTable::get(5000);
+	auto b = LogFactorialTable::get(10);
+	EXPECT_EQ(a, b);
+	EXPECT_GE(a->max(), 5000u);
+	EXPECT_TRUE(bfs::exists(directory / "log_factorials_5000.bin"));
+
+	LogFactorialTable::setCacheDirectory("");
+	bfs::remove_all(directory);
+}
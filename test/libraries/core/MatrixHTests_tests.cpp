@@ -5,6 +5,7 @@
 
 #include <config.h>
 
+#include <limits>
 #include <vector>
 
 using namespace GeneTrail;
@@ -56,3 +57,150 @@ TEST(MatrixHTest, Zscore)
 	EXPECT_NEAR(scores[2].score(), 0.7109566, TOLERANCE);
 }
 
+
+TEST(MatrixHTest, momentBasedTestsMatchScalarTests)
+{
+	const size_t rows = 50;
+	DenseMatrix reference(rows, 7);
+	DenseMatrix sample(rows, 7);
+
+	std::vector<std::string> names;
+	for(size_t i = 0; i < rows; ++i) {
+		names.push_back("R" + std::to_string(i));
+		for(size_t j = 0; j < 7; ++j) {
+			reference(i, j) = 1.0 + std::sin(3.0 * i + j) + 0.1 * j;
+			sample(i, j) = 1.5 + std::cos(2.0 * i + 5.0 * j);
+		}
+	}
+	reference.setRowNames(names);
+	sample.setRowNames(names);
+
+	MatrixHTest htest;
+	auto t_scores = htest.test("independent-t-test", reference, sample);
+	auto d_scores = htest.test("dependent-t-test", reference, sample);
+	auto f_scores = htest.test("f-test", reference, sample);
+	auto snr_scores = htest.test("signal-to-noise-ratio", reference, sample);
+	auto mfq_scores = htest.test("mean-fold-quotient", reference, sample);
+	auto mfd_scores = htest.test("mean-fold-difference", reference, sample);
+
+	for(size_t i = 0; i < rows; ++i) {
+		std::vector<double> a, b;
+		for(size_t j = 0; j < 7; ++j) {
+			a.push_back(reference(i, j));
+			b.push_back(sample(i, j));
+		}
+
+		IndependentTTest<double> t;
+		DependentTTest<double> d;
+		FTest<double> f;
+		SignalToNoiseRatio<double> snr;
+
+		EXPECT_NEAR(t.test(a.begin(), a.end(), b.begin(), b.end()), t_scores[i].score(), 1e-10);
+		EXPECT_NEAR(d.test(a.begin(), a.end(), b.begin(), b.end()), d_scores[i].score(), 1e-10);
+		EXPECT_NEAR(f.test(a.begin(), a.end(), b.begin(), b.end()), f_scores[i].score(), 1e-10);
+		EXPECT_NEAR(snr.test(a.begin(), a.end(), b.begin(), b.end()), snr_scores[i].score(), 1e-10);
+		EXPECT_NEAR(statistic::mean_fold_quotient<double>(a.begin(), a.end(), b.begin(), b.end()), mfq_scores[i].score(), 1e-10);
+		EXPECT_NEAR(statistic::mean_fold_difference<double>(a.begin(), a.end(), b.begin(), b.end()), mfd_scores[i].score(), 1e-10);
+	}
+}
+
+TEST(MatrixHTest, shrinkageTTestMatchesRowWiseTest)
+{
+	// More rows than fit into a single block of the column-wise kernel.
+	const size_t rows = 600;
+	DenseMatrix reference(rows, 6);
+	DenseMatrix sample(rows, 5);
+
+	std::vector<std::string> names;
+	std::vector<std::vector<double>> a(rows), b(rows), a_nan(rows), b_nan(rows);
+	for(size_t i = 0; i < rows; ++i) {
+		names.push_back("R" + std::to_string(i));
+		for(size_t j = 0; j < 6; ++j) {
+			reference(i, j) = 1.0 + std::sin(3.0 * i + j) + 0.1 * j;
+			a[i].push_back(reference(i, j));
+		}
+		for(size_t j = 0; j < 5; ++j) {
+			sample(i, j) = 1.5 + std::cos(2.0 * i + 5.0 * j);
+			b[i].push_back(sample(i, j));
+		}
+	}
+	reference.setRowNames(names);
+	sample.setRowNames(names);
+
+	MatrixHTest htest;
+	htest.setNumberOfThreads(3);
+
+	IndependentShrinkageTTest<double> t;
+	auto expected = t.test(a.begin(), a.end(), b.begin(), b.end());
+	auto scores = htest.test("independent-shrinkage-t-test", reference, sample);
+
+	ASSERT_EQ(rows, scores.size());
+	for(size_t i = 0; i < rows; ++i) {
+		EXPECT_NEAR(expected[i], scores[i].score(), 1e-10);
+	}
+
+	for(size_t i = 0; i < rows; i += 7) {
+		reference(i, i % 6) = std::numeric_limits<double>::quiet_NaN();
+		sample(i, i % 5) = std::numeric_limits<double>::quiet_NaN();
+	}
+
+	for(size_t i = 0; i < rows; ++i) {
+		for(size_t j = 0; j < 6; ++j) {
+			a_nan[i].push_back(reference(i, j));
+		}
+		for(size_t j = 0; j < 5; ++j) {
+			b_nan[i].push_back(sample(i, j));
+		}
+	}
+
+	expected = t.testRemoveNaN(a_nan.begin(), a_nan.end(), b_nan.begin(),
+	                           b_nan.end());
+	scores = htest.test("independent-shrinkage-t-test", reference, sample,
+	                    NanMode::Remove);
+
+	ASSERT_EQ(rows, scores.size());
+	for(size_t i = 0; i < rows; ++i) {
+		EXPECT_NEAR(expected[i], scores[i].score(), 1e-10);
+	}
+}
+
+TEST(MatrixHTest, medianBasedTestsMatchScalarTests)
+{
+	// More rows than fit into a single block of rowMedians and groups
+	// with an odd and an even number of columns.
+	const size_t rows = 300;
+	DenseMatrix matrix(rows, 13);
+
+	std::vector<std::string> names;
+	for(size_t i = 0; i < rows; ++i) {
+		names.push_back("R" + std::to_string(i));
+		for(size_t j = 0; j < 13; ++j) {
+			matrix(i, j) = 2.0 + std::sin(3.0 * i + 7.0 * j);
+		}
+	}
+	matrix.setRowNames(names);
+
+	std::vector<size_t> ref_cols{0, 2, 4, 6, 8, 10, 12};
+	std::vector<size_t> sam_cols{1, 3, 5, 7, 9, 11};
+	DenseColumnSubset reference(&matrix, ref_cols.begin(), ref_cols.end());
+	DenseColumnSubset sample(&matrix, sam_cols.begin(), sam_cols.end());
+
+	MatrixHTest htest;
+	auto lmfq_scores = htest.test("log-median-fold-quotient", reference, sample);
+	auto mfq_scores = htest.test("median-fold-quotient", reference, sample);
+	auto mfd_scores = htest.test("median-fold-difference", reference, sample);
+
+	for(size_t i = 0; i < rows; ++i) {
+		std::vector<double> a, b;
+		for(auto j : ref_cols) {
+			a.push_back(matrix(i, j));
+		}
+		for(auto j : sam_cols) {
+			b.push_back(matrix(i, j));
+		}
+
+		EXPECT_DOUBLE_EQ(statistic::log_median_fold_quotient<double>(a.begin(), a.end(), b.begin(), b.end()), lmfq_scores[i].score());
+		EXPECT_DOUBLE_EQ(statistic::median_fold_quotient<double>(a.begin(), a.end(), b.begin(), b.end()), mfq_scores[i].score());
+		EXPECT_DOUBLE_EQ(statistic::median_fold_difference<double>(a.begin(), a.end(), b.begin(), b.end()), mfd_scores[i].score());
+	}
+}
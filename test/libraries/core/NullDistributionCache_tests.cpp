@@ -0,0 +1,286 @@
+/*
+ * GeneTrail2 - An efficient library for interpreting genetic data
+ * Copyright (C) 2016 Daniel Stöckel <dstoeckel@bioinf.uni-sb.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Lesser GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Lesser GNU General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <genetrail2/core/EntityDatabase.h>
+#include <genetrail2/core/Exception.h>
+#include <genetrail2/core/Scores.h>
+#include <genetrail2/enrichment/NullDistributionCache.h>
+
+#include <gtest/gtest.h>
+
+#include <boost/filesystem.hpp>
+
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <memory>
+
+using namespace GeneTrail;
+
+namespace bfs = boost::filesystem;
+
+class NullDistributionCacheTest : public ::testing::Test
+{
+	protected:
+	// Magic number and number of entries
+	static const size_t HEADER_SIZE = 16;
+	// Five key fields, the offset and the count
+	static const size_t ENTRY_SIZE = 7 * sizeof(uint64_t);
+
+	void SetUp() override
+	{
+		directory_ = bfs::temp_directory_path() / bfs::unique_path();
+		bfs::create_directory(directory_);
+		path_ = (directory_ / "null.bin").string();
+	}
+
+	void TearDown() override { bfs::remove_all(directory_); }
+
+	static NullDistributionKey key(uint64_t n, uint64_t hits)
+	{
+		NullDistributionKey key;
+		key.n = n;
+		key.hits = hits;
+		key.statistic = 1;
+		key.order = 0;
+		key.scores = 2;
+		return key;
+	}
+
+	static NullDistributionCache::Distributions distributions()
+	{
+		NullDistributionCache::Distributions dists;
+		dists[key(10, 3)] = {0.5, -1.0, 2.0, 0.0};
+		dists[key(10, 1)] = {3.0, 1.0};
+		dists[key(20, 3)] = {};
+		return dists;
+	}
+
+	/// Overwrites the 64 bit value at the given offset of the file.
+	void patch(size_t offset, uint64_t value) const
+	{
+		std::fstream strm(path_, std::ios::binary | std::ios::in |
+		                             std::ios::out);
+		strm.seekp(offset);
+		strm.write(reinterpret_cast<const char*>(&value), sizeof(value));
+	}
+
+	bfs::path directory_;
+	std::string path_;
+};
+
+TEST_F(NullDistributionCacheTest, binaryFormat)
+{
+	auto dists = distributions();
+	NullDistributionCache::write(path_, dists);
+
+	// Header, three entries and six values.
+	ASSERT_EQ(HEADER_SIZE + 3 * ENTRY_SIZE + 6 * sizeof(double),
+	          bfs::file_size(path_));
+
+	std::ifstream strm(path_, std::ios::binary);
+	char magic[8];
+	uint64_t numEntries;
+	strm.read(magic, sizeof(magic));
+	strm.read(reinterpret_cast<char*>(&numEntries), sizeof(numEntries));
+	EXPECT_EQ("GT2NULL1", std::string(magic, sizeof(magic)));
+	EXPECT_EQ(3u, numEntries);
+
+	// The entries are sorted by key and refer to consecutive ranges.
+	const std::vector<std::pair<uint64_t, uint64_t>> expected{
+	    {10, 1}, {10, 3}, {20, 3}};
+	uint64_t offset = 0;
+	for(const auto& e : expected) {
+		uint64_t entry[7];
+		strm.read(reinterpret_cast<char*>(entry), sizeof(entry));
+		EXPECT_EQ(e.first, entry[0]);
+		EXPECT_EQ(e.second, entry[1]);
+		EXPECT_EQ(offset, entry[5]);
+		offset += entry[6];
+	}
+	EXPECT_EQ(6u, offset);
+
+	// The values of every distribution are sorted.
+	std::vector<double> values(6);
+	strm.read(reinterpret_cast<char*>(values.data()), 6 * sizeof(double));
+	EXPECT_EQ((std::vector<double>{1.0, 3.0, -1.0, 0.0, 0.5, 2.0}), values);
+}
+
+TEST_F(NullDistributionCacheTest, find)
+{
+	auto dists = distributions();
+	NullDistributionCache::write(path_, dists);
+
+	NullDistributionCache cache(path_);
+	EXPECT_EQ(3u, cache.size());
+
+	auto range = cache.find(key(10, 3));
+	EXPECT_EQ((std::vector<double>{-1.0, 0.0, 0.5, 2.0}),
+	          std::vector<double>(range.first, range.second));
+
+	range = cache.find(key(10, 1));
+	EXPECT_EQ((std::vector<double>{1.0, 3.0}),
+	          std::vector<double>(range.first, range.second));
+
+	range = cache.find(key(20, 3));
+	EXPECT_NE(nullptr, range.first);
+	EXPECT_EQ(range.first, range.second);
+
+	range = cache.find(key(10, 2));
+	EXPECT_EQ(nullptr, range.first);
+	EXPECT_EQ(nullptr, range.second);
+
+	NullDistributionCache::Distributions read;
+	cache.read(read);
+	ASSERT_EQ(dists.size(), read.size());
+	for(const auto& dist : dists) {
+		ASSERT_EQ(1u, read.count(dist.first));
+		EXPECT_EQ(dist.second, read[dist.first]);
+	}
+}
+
+TEST_F(NullDistributionCacheTest, writeReplacesMappedFile)
+{
+	auto dists = distributions();
+	NullDistributionCache::write(path_, dists);
+	NullDistributionCache old(path_);
+
+	NullDistributionCache::Distributions other;
+	other[key(5, 2)] = {4.0};
+	NullDistributionCache::write(path_, other);
+
+	// The mapping of the old file is not affected by the new one.
+	auto range = old.find(key(10, 1));
+	EXPECT_EQ((std::vector<double>{1.0, 3.0}),
+	          std::vector<double>(range.first, range.second));
+
+	NullDistributionCache cache(path_);
+	EXPECT_EQ(1u, cache.size());
+	EXPECT_EQ(nullptr, cache.find(key(10, 1)).first);
+
+	// No temporary file is left behind.
+	EXPECT_EQ(1, std::distance(bfs::directory_iterator(directory_),
+	                           bfs::directory_iterator()));
+}
+
+TEST_F(NullDistributionCacheTest, fingerprint)
+{
+	auto db = std::make_shared<EntityDatabase>();
+
+	Scores a(db);
+	a.emplace_back("A", 1.0);
+	a.emplace_back("B", 2.0);
+
+	Scores b(db);
+	b.emplace_back("A", 1.0);
+	b.emplace_back("B", 2.0);
+
+	Scores c(db);
+	c.emplace_back("A", 1.0);
+	c.emplace_back("B", 2.5);
+
+	// Only the values matter, not the entities they belong to.
+	Scores d(db);
+	d.emplace_back("C", 2.0);
+	d.emplace_back("D", 1.0);
+
+	auto equal = [](const NullDistributionKey& x,
+	                const NullDistributionKey& y) {
+		return !(x < y) && !(y < x);
+	};
+
+	NullDistributionKey ka("mean", 0, a);
+	EXPECT_EQ(2u, ka.n);
+	EXPECT_EQ(0u, ka.hits);
+
+	EXPECT_TRUE(equal(ka, NullDistributionKey("mean", 0, b)));
+	EXPECT_FALSE(equal(ka, NullDistributionKey("mean", 0, c)));
+	EXPECT_TRUE(equal(ka, NullDistributionKey("mean", 0, d)));
+	EXPECT_FALSE(equal(ka, NullDistributionKey("median", 0, a)));
+	EXPECT_FALSE(equal(ka, NullDistributionKey("mean", 1, a)));
+
+	auto kb = NullDistributionKey("mean", 0, b);
+	kb.hits = 1;
+	EXPECT_FALSE(equal(ka, kb));
+}
+
+TEST_F(NullDistributionCacheTest, rejectsMissingFile)
+{
+	EXPECT_THROW(NullDistributionCache((directory_ / "missing").string()),
+	             IOError);
+}
+
+TEST_F(NullDistributionCacheTest, rejectsWrongMagic)
+{
+	auto dists = distributions();
+	NullDistributionCache::write(path_, dists);
+	patch(0, 0);
+
+	EXPECT_THROW(NullDistributionCache cache(path_), IOError);
+}
+
+TEST_F(NullDistributionCacheTest, rejectsTruncatedFile)
+{
+	auto dists = distributions();
+	NullDistributionCache::write(path_, dists);
+	const auto size = bfs::file_size(path_);
+
+	for(auto truncated : {size - sizeof(double), HEADER_SIZE + 2 * ENTRY_SIZE,
+	                      HEADER_SIZE + ENTRY_SIZE / 2, HEADER_SIZE - 1}) {
+		NullDistributionCache::write(path_, dists);
+		bfs::resize_file(path_, truncated);
+		EXPECT_THROW(NullDistributionCache cache(path_), IOError)
+		    << "Size " << truncated;
+	}
+}
+
+TEST_F(NullDistributionCacheTest, rejectsOverflowingEntryCount)
+{
+	auto dists = distributions();
+	NullDistributionCache::write(path_, dists);
+
+	// Multiplied by the size of an entry, these counts wrap around.
+	const uint64_t max = std::numeric_limits<uint64_t>::max();
+	for(uint64_t numEntries : {max, max / ENTRY_SIZE + 1}) {
+		patch(8, numEntries);
+		EXPECT_THROW(NullDistributionCache cache(path_), IOError);
+	}
+}
+
+TEST_F(NullDistributionCacheTest, rejectsCorruptEntries)
+{
+	auto dists = distributions();
+	const size_t offsetField = HEADER_SIZE + 5 * sizeof(uint64_t);
+	const size_t countField = offsetField + sizeof(uint64_t);
+	const uint64_t max = std::numeric_limits<uint64_t>::max();
+
+	// offset + count overflows.
+	NullDistributionCache::write(path_, dists);
+	patch(offsetField, max);
+	EXPECT_THROW(NullDistributionCache cache(path_), IOError);
+
+	NullDistributionCache::write(path_, dists);
+	patch(countField, max);
+	EXPECT_THROW(NullDistributionCache cache(path_), IOError);
+
+	// The entries are no longer sorted.
+	NullDistributionCache::write(path_, dists);
+	patch(HEADER_SIZE, 100);
+	EXPECT_THROW(NullDistributionCache cache(path_), IOError);
+}
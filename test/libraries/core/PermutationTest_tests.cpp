@@ -0,0 +1,393 @@
+/*
+ * GeneTrail2 - An efficient library for interpreting genetic data
+ * Copyright (C) 2016 Daniel Stöckel <dstoeckel@bioinf.uni-sb.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Lesser GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Lesser GNU General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <genetrail2/core/Category.h>
+#include <genetrail2/core/DenseColumnSubset.h>
+#include <genetrail2/core/DenseMatrix.h>
+#include <genetrail2/core/EntityDatabase.h>
+#include <genetrail2/core/MatrixHTest.h>
+#include <genetrail2/core/Scores.h>
+#include <genetrail2/enrichment/EnrichmentAlgorithm.h>
+#include <genetrail2/enrichment/PermutationTest.h>
+#include <genetrail2/enrichment/SetLevelStatistics.h>
+
+#include <gtest/gtest.h>
+
+#include <boost/iterator/counting_iterator.hpp>
+
+#include <cmath>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace GeneTrail;
+
+namespace
+{
+	/**
+	 * Hides the index based interface of an algorithm, so that the
+	 * permutation tests have to score the categories directly.
+	 */
+	class WithoutIndices : public EnrichmentAlgorithm
+	{
+		public:
+		explicit WithoutIndices(EnrichmentAlgorithmPtr algorithm)
+		    : EnrichmentAlgorithm(algorithm->pValueMode()),
+		      algorithm_(std::move(algorithm))
+		{
+		}
+
+		EnrichmentAlgorithmPtr clone() const override
+		{
+			return std::make_unique<WithoutIndices>(algorithm_->clone());
+		}
+
+		bool canUseCategory(const Category& c, size_t hits) const override
+		{
+			return algorithm_->canUseCategory(c, hits);
+		}
+
+		bool rowWisePValueIsDirect() const override
+		{
+			return algorithm_->rowWisePValueIsDirect();
+		}
+
+		bool supportsIndices() const override { return false; }
+
+		Order getOrder() const override { return algorithm_->getOrder(); }
+
+		void setScores(const Scores& scores) override
+		{
+			algorithm_->setScores(scores);
+		}
+
+		std::unique_ptr<EnrichmentResult>
+		computeEnrichment(const std::shared_ptr<Category>& c) override
+		{
+			return algorithm_->computeEnrichment(c);
+		}
+
+		std::tuple<double, double>
+		computeEnrichmentScore(const Category& c) override
+		{
+			return algorithm_->computeEnrichmentScore(c);
+		}
+
+		std::tuple<double, double>
+		computeEnrichmentScore(IndexIterator begin, IndexIterator end) override
+		{
+			return algorithm_->computeEnrichmentScore(begin, end);
+		}
+
+		void computeEnrichmentScores(const std::vector<IndexIterator>& begins,
+		                             size_t length,
+		                             std::vector<double>& scores) override
+		{
+			algorithm_->computeEnrichmentScores(begins, length, scores);
+		}
+
+		void computeRowWisePValues(const EnrichmentResults& results,
+		                           size_t numThreads) override
+		{
+			algorithm_->computeRowWisePValues(results, numThreads);
+		}
+
+		private:
+		EnrichmentAlgorithmPtr algorithm_;
+	};
+}
+
+/**
+ * A data set of 200 genes measured in 10 reference and 10 sample columns.
+ * The genes of the category "enriched" are strongly up-regulated in the
+ * sample, all other categories are drawn from the null hypothesis.
+ */
+class PermutationTestTest : public ::testing::Test
+{
+	protected:
+	static const size_t GENES = 200;
+	static const size_t REFERENCE = 10;
+	static const size_t SAMPLES = 10;
+
+	void SetUp() override
+	{
+		db_ = std::make_shared<EntityDatabase>();
+
+		std::vector<std::string> rows, cols;
+		for(size_t i = 0; i < GENES; ++i) {
+			rows.push_back("G" + std::to_string(i));
+			rowIndices_.push_back(db_->index(rows.back()));
+		}
+		for(size_t j = 0; j < REFERENCE + SAMPLES; ++j) {
+			cols.push_back("C" + std::to_string(j));
+		}
+
+		addCategory("enriched", 0, 20, 1);
+		addCategory("strided", 50, 197, 7);
+		addCategory("block", 100, 140, 1);
+		addCategory("small", 150, 155, 1);
+
+		data_ = DenseMatrix(rows, cols);
+
+		std::mt19937 twister(1234);
+		std::normal_distribution<double> normal;
+		for(size_t i = 0; i < GENES; ++i) {
+			for(size_t j = 0; j < REFERENCE + SAMPLES; ++j) {
+				data_(i, j) = normal(twister);
+				if(i < 20 && j >= REFERENCE) {
+					data_(i, j) += 3.0;
+				}
+			}
+		}
+
+		MatrixHTest scoring;
+		scoring.setRowDBIndices(rowIndices_);
+
+		auto columns = boost::counting_iterator<size_t>(0);
+		DenseColumnSubset ref(&data_, columns, columns + REFERENCE);
+		DenseColumnSubset sam(&data_, columns + REFERENCE,
+		                      columns + REFERENCE + SAMPLES);
+
+		auto observed = scoring.test(MatrixHTests::IndependentTTest, ref, sam);
+
+		// Attach the observed scores to the entity database of the
+		// categories.
+		scores_ = Scores(db_);
+		for(const auto& score : observed) {
+			scores_.emplace_back(score.index(), score.score());
+		}
+		scores_.sortByIndex();
+	}
+
+	void addCategory(const std::string& name, size_t begin, size_t end,
+	                 size_t stride)
+	{
+		Category c(db_.get(), name);
+		for(size_t i = begin; i < end; i += stride) {
+			c.insert(rowIndices_[i]);
+		}
+		categories_.push_back(c);
+	}
+
+	EnrichmentAlgorithmPtr mean(PValueMode mode) const
+	{
+		return createEnrichmentAlgorithm<MeanEnrichment>(mode, scores_);
+	}
+
+	EnrichmentAlgorithmPtr kolmogorovSmirnov(Order order) const
+	{
+		Scores sorted(scores_);
+		sorted.sortByScore(order);
+		return createEnrichmentAlgorithm<KolmogorovSmirnov>(
+		    PValueMode::ColumnWise, sorted.indices().begin(),
+		    sorted.indices().end(), order);
+	}
+
+	EnrichmentAlgorithmPtr weightedKolmogorovSmirnov() const
+	{
+		return createEnrichmentAlgorithm<WeightedKolmogorovSmirnov>(
+		    PValueMode::RowWise, scores_, Order::Decreasing);
+	}
+
+	EnrichmentResults results(const EnrichmentAlgorithmPtr& algorithm) const
+	{
+		// All members of the categories are scored, so every member is a
+		// hit. This mirrors what scoreCategories in common.cpp stores.
+		EnrichmentResults results;
+		for(const auto& c : categories_) {
+			results.emplace_back(
+			    algorithm->computeEnrichment(std::make_shared<Category>(c)));
+			results.back()->hits = c.size();
+			results.back()->hit_ids.assign(c.begin(), c.end());
+		}
+		return results;
+	}
+
+	/// The permutation tests reorder the results, so they are keyed by name.
+	using Outcome = std::map<std::string, std::pair<double, size_t>>;
+
+	static Outcome outcome(const EnrichmentResults& results)
+	{
+		Outcome result;
+		for(const auto& r : results) {
+			result[r->category->name()] =
+			    std::make_pair(r->pvalue.convert_to<double>(), r->permutations);
+		}
+		return result;
+	}
+
+	Outcome rowWise(const EnrichmentAlgorithmPtr& algorithm,
+	                size_t permutations, uint64_t seed, size_t numThreads,
+	                size_t earlyStoppingHits = 0) const
+	{
+		auto test = algorithm->supportsIndices()
+		                ? RowPermutationTest<double>::IndexBased(
+		                      scores_, permutations, seed, numThreads)
+		                : RowPermutationTest<double>::CategoryBased(
+		                      scores_, permutations, seed, numThreads);
+		test->setEarlyStoppingHits(earlyStoppingHits);
+
+		auto tests = results(algorithm);
+		test->computePValue(algorithm, tests);
+		return outcome(tests);
+	}
+
+	Outcome columnWise(const EnrichmentAlgorithmPtr& algorithm,
+	                   size_t permutations, uint64_t seed, size_t numThreads,
+	                   size_t earlyStoppingHits = 0) const
+	{
+		ColumnPermutationTest<double> test(data_, permutations, REFERENCE,
+		                                   MatrixHTests::IndependentTTest,
+		                                   seed, db_.get(), numThreads);
+		test.setEarlyStoppingHits(earlyStoppingHits);
+
+		auto tests = results(algorithm);
+		test.computePValue(algorithm, tests);
+		return outcome(tests);
+	}
+
+	std::shared_ptr<EntityDatabase> db_;
+	std::vector<size_t> rowIndices_;
+	std::vector<Category> categories_;
+	DenseMatrix data_{DenseMatrix::index_type(0), DenseMatrix::index_type(0)};
+	Scores scores_{std::shared_ptr<EntityDatabase>()};
+};
+
+TEST_F(PermutationTestTest, rowWiseIsReproducible)
+{
+	auto category = mean(PValueMode::RowWise);
+	EXPECT_EQ(rowWise(category, 2000, 42, 3), rowWise(category, 2000, 42, 3));
+
+	auto index = weightedKolmogorovSmirnov();
+	EXPECT_EQ(rowWise(index, 2000, 42, 3), rowWise(index, 2000, 42, 3));
+
+	EXPECT_NE(rowWise(category, 2000, 42, 3), rowWise(category, 2000, 43, 3));
+}
+
+TEST_F(PermutationTestTest, columnWiseIsReproducible)
+{
+	auto algorithm = mean(PValueMode::ColumnWise);
+	EXPECT_EQ(columnWise(algorithm, 1000, 42, 3),
+	          columnWise(algorithm, 1000, 42, 3));
+}
+
+TEST_F(PermutationTestTest, rowWiseThreadsAreConsistent)
+{
+	const size_t permutations = 20000;
+
+	for(const auto& algorithm :
+	    {mean(PValueMode::RowWise), weightedKolmogorovSmirnov()}) {
+		auto single = rowWise(algorithm, permutations, 7, 1);
+		auto multi = rowWise(algorithm, permutations, 7, 4);
+
+		ASSERT_EQ(single.size(), multi.size());
+		for(const auto& entry : single) {
+			const double p = entry.second.first;
+			const double q = multi[entry.first].first;
+
+			// Both p-values are independent estimates of the same
+			// probability, so their difference is about normally
+			// distributed with the following standard deviation.
+			const double sd = std::sqrt(2.0 * p * (1.0 - p) / permutations);
+			EXPECT_NEAR(p, q, 6.0 * sd + 2.0 / permutations) << entry.first;
+
+			EXPECT_EQ(permutations, entry.second.second);
+			EXPECT_EQ(permutations, multi[entry.first].second);
+		}
+	}
+}
+
+TEST_F(PermutationTestTest, earlyStoppingReportsUsedPermutations)
+{
+	const size_t permutations = 100000;
+	const size_t hits = 20;
+
+	auto algorithm = mean(PValueMode::RowWise);
+	auto stopped = rowWise(algorithm, permutations, 7, 2, hits);
+
+	// The enriched category is never exceeded and uses the whole budget.
+	EXPECT_EQ(permutations, stopped["enriched"].second);
+	EXPECT_DOUBLE_EQ(1.0 / permutations, stopped["enriched"].first);
+
+	for(const auto& name : {"strided", "block", "small"}) {
+		const size_t used = stopped[name].second;
+
+		// Categories are retired at the end of a round of 1000
+		// permutations. Their p-value is the number of extreme
+		// permutations divided by the number of used permutations.
+		EXPECT_GT(permutations, used) << name;
+		EXPECT_EQ(0u, used % 1000) << name;
+
+		const double extreme = stopped[name].first * used;
+		EXPECT_NEAR(std::round(extreme), extreme, 1e-6) << name;
+		EXPECT_LE(hits, std::round(extreme)) << name;
+
+		if(used == 1000) {
+			continue;
+		}
+
+		// The rounds before do not depend on the budget, so a budget that
+		// ends one round earlier shows that the category was still active
+		// then and had fewer than `hits` extreme permutations.
+		auto earlier = rowWise(algorithm, used - 1000, 7, 2, hits);
+		EXPECT_EQ(used - 1000, earlier[name].second) << name;
+
+		const double counter = earlier[name].first * (used - 1000) - 1.0;
+		EXPECT_GT(hits, std::round(counter)) << name;
+	}
+}
+
+TEST_F(PermutationTestTest, rowAndColumnWiseReportSamePermutations)
+{
+	const size_t permutations = 5000;
+
+	for(size_t hits : {0, 5}) {
+		auto row = rowWise(mean(PValueMode::RowWise), permutations, 11, 2, hits);
+		auto column =
+		    columnWise(mean(PValueMode::ColumnWise), permutations, 11, 2, hits);
+
+		ASSERT_EQ(row.size(), column.size());
+		for(const auto& entry : row) {
+			EXPECT_EQ(entry.second.second, column[entry.first].second)
+			    << entry.first << " " << hits;
+		}
+
+		EXPECT_EQ(permutations, row["enriched"].second);
+		EXPECT_EQ(hits == 0 ? permutations : 1000u, row["block"].second);
+	}
+}
+
+TEST_F(PermutationTestTest, columnWiseLookupTablesMatchCategoryScores)
+{
+	// The index based path sorts the permuted scores by itself. It must
+	// use the order of the statistic, otherwise the scores of the
+	// categories differ from those computed on the categories directly.
+	for(auto order : {Order::Increasing, Order::Decreasing}) {
+		auto index = kolmogorovSmirnov(order);
+		ASSERT_TRUE(index->supportsIndices());
+
+		auto direct = EnrichmentAlgorithmPtr(
+		    std::make_unique<WithoutIndices>(kolmogorovSmirnov(order)));
+
+		EXPECT_EQ(columnWise(direct, 500, 3, 2), columnWise(index, 500, 3, 2))
+		    << static_cast<int>(order);
+	}
+}
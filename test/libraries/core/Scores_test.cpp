@@ -169,6 +169,39 @@ TEST_F(ScoresTest, sortByIndex)
 	EXPECT_FALSE(scores.isSortedByIndex());
 }
 
+TEST_F(ScoresTest, sortByScore)
+{
+	auto db = std::make_shared<EntityDatabase>();
+	Scores scores(db);
+
+	scores.emplace_back("A", 1.2);
+	scores.emplace_back("D", 1.1);
+	scores.emplace_back("G", 1.0);
+	scores.emplace_back("B", -1.2);
+	scores.emplace_back("C", 1.0);
+
+	scores.sortByScore(Order::Decreasing);
+	EXPECT_FALSE(scores.isSortedByIndex());
+
+	// Both arrays are permuted alike, so every score keeps its entity.
+	const std::vector<std::string> names{"A", "D", "C", "G", "B"};
+	const std::vector<double> values{1.2, 1.1, 1.0, 1.0, -1.2};
+
+	const auto indices = scores.indices().data();
+	const auto data = scores.scores().data();
+	for(size_t i = 0; i < scores.size(); ++i) {
+		EXPECT_EQ(names[i], (*db)(indices[i]));
+		EXPECT_EQ(values[i], data[i]);
+	}
+
+	scores.sortByIndex();
+	EXPECT_TRUE(scores.isSortedByIndex());
+	EXPECT_EQ("A", scores[0].name(*db));
+	EXPECT_EQ(1.2, scores[0].score());
+	EXPECT_EQ("B", scores[3].name(*db));
+	EXPECT_EQ(-1.2, scores[3].score());
+}
+
 TEST_F(ScoresTest, subsetSorted)
 {
 	auto db = std::make_shared<EntityDatabase>();
@@ -0,0 +1,207 @@
+/*
+ * GeneTrail2 - An efficient library for interpreting genetic data
+ * Copyright (C) 2016 Daniel Stöckel <dstoeckel@bioinf.uni-sb.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the Lesser GNU General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * Lesser GNU General Public License for more details.
+ *
+ * You should have received a copy of the Lesser GNU General Public
+ * License along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include <genetrail2/core/Category.h>
+#include <genetrail2/core/EntityDatabase.h>
+#include <genetrail2/core/IndependentTTest.h>
+#include <genetrail2/core/Scores.h>
+#include <genetrail2/core/WilcoxonRankSumTest.h>
+#include <genetrail2/enrichment/SetLevelStatistics.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace GeneTrail;
+
+class SetLevelStatisticsTest : public ::testing::Test
+{
+	protected:
+	void SetUp() override
+	{
+		db_ = std::make_shared<EntityDatabase>();
+
+		const std::vector<double> values{2.5, -1.0, 0.3,  4.2, -2.2,
+		                                 0.0, 1.7,  -0.4, 3.1, 0.9};
+		for(size_t i = 0; i < values.size(); ++i) {
+			names_.push_back("G" + std::to_string(i));
+			values_.push_back(values[i]);
+		}
+	}
+
+	Scores scores() const
+	{
+		Scores result(db_);
+		for(size_t i = 0; i < names_.size(); ++i) {
+			result.emplace_back(names_[i], values_[i]);
+		}
+		return result;
+	}
+
+	Category category(const std::vector<size_t>& members) const
+	{
+		Category c(db_.get());
+		for(auto i : members) {
+			c.insert(names_[i]);
+		}
+		return c;
+	}
+
+	/// Splits the values into those of the members and the rest.
+	void split(const std::vector<size_t>& members, std::vector<double>& in,
+	           std::vector<double>& out) const
+	{
+		in.clear();
+		out.clear();
+		for(size_t i = 0; i < values_.size(); ++i) {
+			if(std::find(members.begin(), members.end(), i) !=
+			   members.end()) {
+				in.push_back(values_[i]);
+			} else {
+				out.push_back(values_[i]);
+			}
+		}
+	}
+
+	static void expectSameScore(double expected, double actual)
+	{
+		if(std::isnan(expected)) {
+			EXPECT_TRUE(std::isnan(actual)) << actual;
+		} else {
+			EXPECT_NEAR(expected, actual, 1e-9 * (1.0 + std::abs(expected)));
+		}
+	}
+
+	std::shared_ptr<EntityDatabase> db_;
+	std::vector<std::string> names_;
+	std::vector<double> values_;
+};
+
+TEST_F(SetLevelStatisticsTest, tTestMatchesComplementIterators)
+{
+	HTestEnrichment<IndependentTTest<double>> statistic(scores());
+
+	const std::vector<std::vector<size_t>> categories{
+	    {0, 3, 8},
+	    {1, 4, 7, 5},
+	    {0, 1},
+	    // Singleton complement
+	    {0, 1, 2, 3, 4, 5, 6, 7, 8},
+	    // The category covers every entity
+	    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9}};
+
+	std::vector<double> in, out;
+	for(const auto& members : categories) {
+		split(members, in, out);
+
+		// This is how the scores were computed before the sufficient
+		// statistics were introduced.
+		IndependentTTest<double> test;
+		const double expected =
+		    HTest::test(test, in.begin(), in.end(), out.begin(), out.end());
+
+		const double actual = std::get<0>(statistic.computeScore(category(members)));
+
+		SCOPED_TRACE(members.size());
+		expectSameScore(expected, actual);
+	}
+}
+
+TEST_F(SetLevelStatisticsTest, tTestIgnoresEntitiesWithoutScore)
+{
+	HTestEnrichment<IndependentTTest<double>> statistic(scores());
+
+	auto c = category({0, 3, 8});
+	c.insert("unscored");
+
+	std::vector<double> in, out;
+	split({0, 3, 8}, in, out);
+
+	IndependentTTest<double> test;
+	expectSameScore(
+	    HTest::test(test, in.begin(), in.end(), out.begin(), out.end()),
+	    std::get<0>(statistic.computeScore(c)));
+}
+
+TEST_F(SetLevelStatisticsTest, wilcoxonMatchesRankComputation)
+{
+	// Ties within the category, within the complement and across both.
+	values_ = {1.0, 2.0, 2.0, 3.0, -1.0, 2.0, 0.5, 0.5, 4.0, -1.0};
+
+	const std::vector<std::vector<size_t>> categories{
+	    {1, 2}, {1, 5, 6}, {4, 9}, {0, 3, 8, 7}, {0, 1, 2, 3, 4, 5, 6, 7, 8}};
+
+	// The scores are passed in input order and in reversed order, which
+	// must not change the ranks.
+	for(bool reversed : {false, true}) {
+		const auto& names = names_;
+		Scores input(db_);
+		for(size_t j = 0; j < names.size(); ++j) {
+			const size_t i = reversed ? names.size() - 1 - j : j;
+			input.emplace_back(names[i], values_[i]);
+		}
+
+		HTestEnrichment<WilcoxonRankSumTest<double>> statistic(scores());
+		statistic.setInputScores(input);
+
+		// The positions passed to the index based interface refer to the
+		// scores sorted by getOrder().
+		Scores sorted = input;
+		sorted.sortByScore(statistic.getOrder());
+
+		std::vector<double> in, out;
+		for(const auto& members : categories) {
+			SCOPED_TRACE(::testing::Message() << "reversed " << reversed
+			                                  << ", size " << members.size());
+			split(members, in, out);
+
+			// Ranks all values of the category and its complement.
+			WilcoxonRankSumTest<double> test;
+			const double expected =
+			    test.test(in.begin(), in.end(), out.begin(), out.end());
+
+			// The rank computation before the rank table was introduced.
+			auto c = category(members);
+			Scores subset = scores().subset(c);
+			subset.sortByScore(Order::Increasing);
+			Scores all = scores();
+			all.sortByScore(Order::Increasing);
+			WilcoxonRankSumTest<double> sortedTest;
+			expectSameScore(expected, sortedTest.test_sorted(
+			                              all, subset.begin(), subset.end()));
+
+			expectSameScore(expected,
+			                std::get<0>(statistic.computeScore(c)));
+
+			Indices positions;
+			for(size_t p = 0; p < sorted.size(); ++p) {
+				if(c.contains(sorted[p].index())) {
+					positions.push_back(p);
+				}
+			}
+			expectSameScore(expected,
+			                std::get<0>(statistic.computeScore(
+			                    positions.cbegin(), positions.cend())));
+		}
+	}
+}
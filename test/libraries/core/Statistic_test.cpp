@@ -218,3 +218,25 @@ TEST(Statistic, Spearman)
 	auto covar = statistic::spearman_correlation<double, std::vector<double>::iterator>(tmp.begin(), tmp.end(), tmp2.begin(), tmp2.end());
 	EXPECT_NEAR(covar, -0.06666667, TOLERANCE);
 }
+
+TEST(Statistic, Ranks)
+{
+	std::vector<double> values{3.0, 1.0, 4.0, 1.0, 5.0, 9.0, 2.0, 6.0, 5.0, 5.0};
+	auto r = statistic::ranks<double>(values.begin(), values.end());
+
+	std::vector<double> expected{4.0, 1.5, 5.0, 1.5, 7.0, 10.0, 3.0, 9.0, 7.0, 7.0};
+	EXPECT_EQ(expected, r);
+
+	std::vector<double> out(values.size());
+	std::vector<size_t> order;
+	statistic::ranks(values.begin(), values.end(), out.begin(), order);
+	EXPECT_EQ(expected, out);
+}
+
+TEST(Statistic, SpearmanWithTies)
+{
+	std::vector<double> x{1.0, 2.0, 2.0, 3.0, 4.0};
+	std::vector<double> y{1.0, 3.0, 2.0, 2.0, 5.0};
+	auto rho = statistic::spearman_correlation<double>(x.begin(), x.end(), y.begin(), y.end());
+	EXPECT_NEAR(rho, 0.7631579, TOLERANCE);
+}